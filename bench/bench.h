@@ -0,0 +1,61 @@
+/*
+ * bench.h
+ * -------
+ * Helpers shared by the benchmark programs in bench/.
+ *
+ *   now_sec()       - monotonic wall clock in seconds
+ *   populate_dir()  - create a flat directory of empty files for a benchmark
+ */
+
+#ifndef MYLS_BENCH_H
+#define MYLS_BENCH_H
+
+#include "myls.h"
+#include<time.h>
+#include<unistd.h>
+
+static volatile size_t bench_sink;
+
+static inline double now_sec(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * populate_dir
+ * ------------
+ * Ensure path is a directory holding at least entries files named
+ * entry-00000000, entry-00000001, ... Existing files are kept, so repeated
+ * benchmark runs reuse the same tree.
+ */
+static inline void populate_dir(const char* path, size_t entries){
+    mkdir(path, 0755);
+    int dfd = open(path, O_RDONLY | O_DIRECTORY);
+    if(dfd < 0){
+        perror(path);
+        exit(1);
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "entry-%08zu", entries ? entries - 1 : 0);
+    struct stat st;
+    if(entries == 0 || !fstatat(dfd, name, &st, AT_SYMLINK_NOFOLLOW)){
+        close(dfd);
+        return;
+    }
+
+    fprintf(stderr, "populating %s with %zu entries...\n", path, entries);
+    for(size_t i = 0; i < entries; ++i){
+        snprintf(name, sizeof(name), "entry-%08zu", i);
+        int fd = openat(dfd, name, O_CREAT | O_WRONLY, 0644);
+        if(fd < 0){
+            perror(name);
+            exit(1);
+        }
+        close(fd);
+    }
+    close(dfd);
+}
+
+#endif
@@ -0,0 +1,106 @@
+/*
+ * name_bench
+ * ----------
+ * Microbenchmark of name ordering on realistic filename sets: plain
+ * strcmp() over key names versus sort_file_list() with prefix-packed keys.
+ *
+ * Usage:
+ *   ./bench/name_bench [ENTRIES] [RUNS]
+ *
+ * Behavior:
+ *   - Generates ENTRIES (default 100000) names for each set:
+ *       uuid    - random version-4 UUIDs
+ *       dated   - dated log names ("app-2024-03-17T08:15:02.123.log")
+ *       shared  - long shared prefix ("build/artifact_shard_000123.o" style)
+ *       short   - short random lowercase names (1..8 chars)
+ *   - Sorts each set RUNS times (default 5) with both implementations and
+ *     checks that they produce the same order
+ *   - Reports the best time and ns/entry per implementation
+ */
+
+#include "bench.h"
+
+static int cmp_strcmp_keys(const void *a, const void *b){
+    return strcmp(((const sort_key_t*)a)->name, ((const sort_key_t*)b)->name);
+}
+
+static int gen_name(int set, int i, char* buf, size_t size){
+    static const char hex[] = "0123456789abcdef";
+    switch(set){
+    case 0: {
+        int n = 0;
+        for(int k = 0; k < 36; ++k)
+            buf[n++] = (k == 8 || k == 13 || k == 18 || k == 23) ? '-' : hex[rand() % 16];
+        buf[n] = '\0';
+        return n;
+    }
+    case 1:
+        return snprintf(buf, size, "app-2024-%02d-%02dT%02d:%02d:%02d.%03d.log",
+                        rand() % 12 + 1, rand() % 28 + 1, rand() % 24,
+                        rand() % 60, rand() % 60, rand() % 1000);
+    case 2:
+        return snprintf(buf, size, "project_build_artifact_shard_%06d.o", i);
+    default: {
+        int len = rand() % 8 + 1;
+        for(int k = 0; k < len; ++k)
+            buf[k] = (char)('a' + rand() % 26);
+        buf[len] = '\0';
+        return len;
+    }
+    }
+}
+
+int main(int argc, char** argv){
+    int entries = argc > 1 ? atoi(argv[1]) : 100000;
+    int runs = argc > 2 ? atoi(argv[2]) : 5;
+    static const char* sets[] = {"uuid", "dated", "shared", "short"};
+
+    for(int set = 0; set < 4; ++set){
+        file_list_t flist;
+        file_list_init(&flist);
+        srand(1234 + set);
+        for(int i = 0; i < entries; ++i){
+            char name[128];
+            int len = gen_name(set, i, name, sizeof(name));
+            file_list_add(&flist, name, (size_t)len);
+        }
+        // shuffle so the "shared" set is not pre-sorted
+        for(int i = entries - 1; i > 0; --i){
+            int j = rand() % (i + 1);
+            file_info_t tmp = flist.files[i];
+            flist.files[i] = flist.files[j];
+            flist.files[j] = tmp;
+        }
+
+        sort_key_t* keys = xmalloc((size_t)entries * sizeof(sort_key_t));
+        double best_strcmp = 1e30, best_prefix = 1e30;
+        for(int r = 0; r < runs; ++r){
+            for(int i = 0; i < entries; ++i)
+                keys[i].name = flist.files[i].name;
+            double t0 = now_sec();
+            qsort(keys, entries, sizeof(sort_key_t), cmp_strcmp_keys);
+            double dt = now_sec() - t0;
+            if(dt < best_strcmp)
+                best_strcmp = dt;
+
+            t0 = now_sec();
+            sort_file_list(&flist, false);
+            dt = now_sec() - t0;
+            if(dt < best_prefix)
+                best_prefix = dt;
+        }
+
+        for(int i = 0; i < entries; ++i)
+            if(strcmp(keys[i].name, file_list_at(&flist, i)->name)){
+                fprintf(stderr, "%s: order mismatch at %d\n", sets[set], i);
+                return 1;
+            }
+
+        printf("%-7s %8d entries  strcmp %8.3f ms (%6.1f ns/entry)  prefix %8.3f ms (%6.1f ns/entry)\n",
+               sets[set], entries, best_strcmp * 1e3, best_strcmp * 1e9 / entries,
+               best_prefix * 1e3, best_prefix * 1e9 / entries);
+        free(keys);
+        file_list_free(&flist);
+    }
+    return 0;
+}
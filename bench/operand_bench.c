@@ -0,0 +1,141 @@
+/*
+ * operand_bench
+ * -------------
+ * Measure operand handling for huge argument lists: the original
+ * opendir()/lstat() classification against classify_operands(), serially
+ * and on the --jobs stat pool, followed by sort_operands().
+ *
+ * Usage:
+ *   ./bench/operand_bench DIR [OPERANDS] [RUNS] [JOBS]
+ *
+ * Behavior:
+ *   - Populates DIR with OPERANDS empty files (default 1000000) if needed
+ *     and passes each of them as a "DIR/entry-N" operand, in shuffled order
+ *   - Classifies the operands RUNS times (default 3) per implementation;
+ *     the pool uses JOBS workers (default 8)
+ *   - Sorts the classified operands by name and by mtime (-t)
+ *   - Reports the best wall time and ns/operand per step
+ */
+
+#include "bench.h"
+
+static void report(const char* label, double best, int count){
+    printf("%-22s %9d operands %9.3f ms %7.1f ns/operand\n",
+           label, count, best * 1e3, best * 1e9 / count);
+}
+
+// classification used before operand records: opendir() probe + lstat()
+static double time_legacy(char** paths, int count){
+    char** dirs = xmalloc((size_t)count * sizeof(char*));
+    char** files = xmalloc((size_t)count * sizeof(char*));
+    int ndirs = 0, nfiles = 0;
+    double t0 = now_sec();
+    for(int i = 0; i < count; ++i){
+        DIR* d = opendir(paths[i]);
+        if(d){
+            closedir(d);
+            dirs[ndirs++] = paths[i];
+            continue;
+        }
+        struct stat st;
+        if(!lstat(paths[i], &st))
+            files[nfiles++] = paths[i];
+    }
+    double dt = now_sec() - t0;
+    bench_sink += (size_t)(ndirs + nfiles);
+    free(dirs);
+    free(files);
+    return dt;
+}
+
+static double time_classify(char** paths, int count, const options_t* opts,
+                            operand_list_t* files){
+    operand_list_t dirs;
+    operand_list_init(&dirs);
+    operand_list_free(files);
+    double t0 = now_sec();
+    classify_operands(paths, count, opts, files, &dirs);
+    double dt = now_sec() - t0;
+    operand_list_free(&dirs);
+    return dt;
+}
+
+int main(int argc, char** argv){
+    if(argc < 2){
+        fprintf(stderr, "usage: %s DIR [OPERANDS] [RUNS] [JOBS]\n", argv[0]);
+        return 1;
+    }
+    const char* path = argv[1];
+    int count = argc > 2 ? atoi(argv[2]) : 1000000;
+    int runs = argc > 3 ? atoi(argv[3]) : 3;
+    int jobs = argc > 4 ? atoi(argv[4]) : 8;
+
+    populate_dir(path, (size_t)count);
+    out_init(STDOUT_FILENO, 0);
+
+    // build the argument list, shuffled like a glob over unordered input
+    char** paths = xmalloc((size_t)count * sizeof(char*));
+    for(int i = 0; i < count; ++i){
+        char buf[PATH_MAX];
+        int len = snprintf(buf, sizeof(buf), "%s/entry-%08d", path, i);
+        paths[i] = xmalloc((size_t)len + 1);
+        memcpy(paths[i], buf, (size_t)len + 1);
+    }
+    srand(7);
+    for(int i = count - 1; i > 0; --i){
+        int j = rand() % (i + 1);
+        char* tmp = paths[i];
+        paths[i] = paths[j];
+        paths[j] = tmp;
+    }
+
+    options_t opts = {.sort_time = true, .jobs = 1};
+    operand_list_t files;
+    operand_list_init(&files);
+
+    double best = 1e30;
+    for(int r = 0; r < runs; ++r){
+        double dt = time_legacy(paths, count);
+        best = dt < best ? dt : best;
+    }
+    report("opendir+lstat", best, count);
+
+    best = 1e30;
+    for(int r = 0; r < runs; ++r){
+        double dt = time_classify(paths, count, &opts, &files);
+        best = dt < best ? dt : best;
+    }
+    report("classify serial", best, count);
+
+    stat_pool_start(jobs);
+    best = 1e30;
+    for(int r = 0; r < runs; ++r){
+        double dt = time_classify(paths, count, &opts, &files);
+        best = dt < best ? dt : best;
+    }
+    char label[32];
+    snprintf(label, sizeof(label), "classify --jobs %d", jobs);
+    report(label, best, count);
+    stat_pool_stop();
+
+    // sort copies of the classified operands
+    operand_t* work = xmalloc((size_t)files.count * sizeof(operand_t));
+    for(int mode = 0; mode < 2; ++mode){
+        best = 1e30;
+        for(int r = 0; r < runs; ++r){
+            memcpy(work, files.items, (size_t)files.count * sizeof(operand_t));
+            double t0 = now_sec();
+            sort_operands(work, files.count, mode == 1);
+            double dt = now_sec() - t0;
+            best = dt < best ? dt : best;
+        }
+        report(mode ? "sort_operands -t" : "sort_operands name", best, files.count);
+    }
+
+    free(work);
+    operand_list_free(&files);
+    for(int i = 0; i < count; ++i)
+        free(paths[i]);
+    free(paths);
+    return out_flush() ? 1 : 0;
+}
@@ -0,0 +1,341 @@
+/*
+ * run_bench
+ * ---------
+ * Time myls against GNU ls on the trees built by tree_gen and write the
+ * results as JSON.
+ *
+ * Usage:
+ *   ./bench/run_bench ROOT MYLS OUT.json [RUNS]
+ *
+ * Behavior:
+ *   - Runs every case of the table below whose tree exists under ROOT:
+ *     myls with the case's options and, when the case has a GNU
+ *     equivalent, `ls` from PATH (skipped if it is not GNU coreutils)
+ *   - Both run with LC_ALL=C and COLUMNS=80, stdout and stderr sent to
+ *     /dev/null; each command runs once untimed (its output is hashed to
+ *     check that myls and ls print the same bytes), then RUNS times
+ *     (default 3) timed
+ *   - Reports the best and median wall time, mean user and system CPU
+ *     time and peak RSS per command, prints a summary table and writes
+ *     everything to OUT.json
+ */
+
+#include "bench.h"
+#include<sys/resource.h>
+#include<sys/wait.h>
+
+#define MAX_ARGS 16
+
+/*
+ * bench_case_t
+ * ------------
+ * One measurement.
+ *
+ * Fields:
+ *   tree - directory under ROOT to list
+ *   myls - myls options, space separated
+ *   gnu  - equivalent GNU ls options, or NULL if there is none
+ */
+typedef struct{
+    const char* tree;
+    const char* myls;
+    const char* gnu;
+}bench_case_t;
+
+#define FLAT_CASES(tree) \
+    {tree, "", ""}, \
+    {tree, "-a", "-a"}, \
+    {tree, "-t", "-t"}, \
+    {tree, "-l", "-l"}, \
+    {tree, "-U", "-U"}, \
+    {tree, "-C", "-C"}, \
+    {tree, "-t --jobs=4", "-t"}, \
+    {tree, "-t --io-uring", "-t"}, \
+    {tree, "-t --head=100", NULL}
+
+#define RECURSIVE_CASES(tree) \
+    {tree, "-R", "-R"}, \
+    {tree, "-Ra", "-Ra"}, \
+    {tree, "-Rt", "-Rt"}, \
+    {tree, "-R --jobs=4", "-R"}
+
+static const bench_case_t cases[] = {
+    FLAT_CASES("flat-1k"),
+    FLAT_CASES("flat-100k"),
+    FLAT_CASES("flat-1m"),
+    RECURSIVE_CASES("deep"),
+    RECURSIVE_CASES("tree"),
+    {"long-names", "", ""},
+    {"long-names", "-t", "-t"},
+    {"long-names", "-C", "-C"},
+    {"long-names", "-l", "-l"},
+    {"mixed-mtime", "-t", "-t"},
+    {"mixed-mtime", "-lt", "-lt"},
+    {"mixed-mtime", "-t --jobs=4", "-t"},
+};
+
+/*
+ * run_result_t
+ * ------------
+ * Measurements of one command over all timed runs.
+ *
+ * Fields:
+ *   ok       - every run exited with status 0
+ *   best     - fastest wall time, in ms
+ *   median   - median wall time, in ms
+ *   user     - mean user CPU time, in ms
+ *   sys      - mean system CPU time, in ms
+ *   max_rss  - peak resident set size, in KiB
+ *   hash     - FNV-1a hash of the output
+ *   bytes    - length of the output
+ */
+typedef struct{
+    bool ok;
+    double best;
+    double median;
+    double user;
+    double sys;
+    long max_rss;
+    uint64_t hash;
+    size_t bytes;
+}run_result_t;
+
+static double tv_ms(struct timeval tv){
+    return tv.tv_sec * 1e3 + tv.tv_usec / 1e3;
+}
+
+static int cmp_double(const void* a, const void* b){
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * spawn
+ * -----
+ * Run argv with stdout sent to out_fd and stderr to /dev/null.
+ *
+ * Returns:
+ *   The child's pid, or -1 if fork() fails.
+ */
+static pid_t spawn(char** argv, int out_fd){
+    pid_t pid = fork();
+    if(pid == 0){
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(out_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+    return pid;
+}
+
+/*
+ * hash_output
+ * -----------
+ * Run argv once, reading its output through a pipe.
+ *
+ * Returns:
+ *   true if it exited with status 0; the FNV-1a hash and length of the
+ *   output are stored in res.
+ */
+static bool hash_output(char** argv, run_result_t* res){
+    int fds[2];
+    if(pipe(fds))
+        return false;
+    pid_t pid = spawn(argv, fds[1]);
+    close(fds[1]);
+    uint64_t h = 0xcbf29ce484222325ull;
+    size_t bytes = 0;
+    char buf[65536];
+    ssize_t n;
+    while((n = read(fds[0], buf, sizeof(buf))) > 0){
+        for(ssize_t i = 0; i < n; ++i)
+            h = (h ^ (unsigned char)buf[i]) * 0x100000001b3ull;
+        bytes += (size_t)n;
+    }
+    close(fds[0]);
+    int status;
+    if(pid < 0 || waitpid(pid, &status, 0) < 0)
+        return false;
+    res->hash = h;
+    res->bytes = bytes;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static run_result_t measure(char** argv, int runs){
+    run_result_t res;
+    memset(&res, 0, sizeof(res));
+    res.ok = hash_output(argv, &res);
+
+    int null_fd = open("/dev/null", O_WRONLY);
+    double* wall = xmalloc((size_t)runs * sizeof(double));
+    for(int r = 0; r < runs && res.ok; ++r){
+        double t0 = now_sec();
+        pid_t pid = spawn(argv, null_fd);
+        int status;
+        struct rusage ru;
+        if(pid < 0 || wait4(pid, &status, 0, &ru) < 0 || !WIFEXITED(status) || WEXITSTATUS(status)){
+            res.ok = false;
+            break;
+        }
+        wall[r] = (now_sec() - t0) * 1e3;
+        res.user += tv_ms(ru.ru_utime) / runs;
+        res.sys += tv_ms(ru.ru_stime) / runs;
+        if(ru.ru_maxrss > res.max_rss)
+            res.max_rss = ru.ru_maxrss;
+    }
+    if(res.ok && runs > 0){
+        qsort(wall, (size_t)runs, sizeof(double), cmp_double);
+        res.best = wall[0];
+        res.median = wall[runs / 2];
+    }
+    free(wall);
+    close(null_fd);
+    return res;
+}
+
+// split opts into argv after prog; the strings point into buf
+static void build_argv(char** argv, char* buf, size_t size, const char* prog, const char* opts, const char* path){
+    snprintf(buf, size, "%s", opts);
+    int n = 0;
+    argv[n++] = (char*)prog;
+    for(char* tok = strtok(buf, " "); tok && n < MAX_ARGS - 2; tok = strtok(NULL, " "))
+        argv[n++] = tok;
+    argv[n++] = (char*)path;
+    argv[n] = NULL;
+}
+
+// first line of `ls --version` if it is GNU coreutils, else NULL
+static char* gnu_ls_version(void){
+    char* argv[] = {"ls", "--version", NULL};
+    int fds[2];
+    if(pipe(fds))
+        return NULL;
+    pid_t pid = spawn(argv, fds[1]);
+    close(fds[1]);
+    char buf[256];
+    ssize_t n = read(fds[0], buf, sizeof(buf) - 1);
+    close(fds[0]);
+    if(pid > 0)
+        waitpid(pid, NULL, 0);
+    if(n <= 0)
+        return NULL;
+    buf[n] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+    if(!strstr(buf, "GNU coreutils"))
+        return NULL;
+    return strdup(buf);
+}
+
+static void json_result(FILE* f, const char* key, const run_result_t* r){
+    fprintf(f, ",\"%s\":", key);
+    if(!r->ok){
+        fprintf(f, "null");
+        return;
+    }
+    fprintf(f, "{\"best_ms\":%.3f,\"median_ms\":%.3f,\"user_ms\":%.3f,\"sys_ms\":%.3f,"
+               "\"max_rss_kib\":%ld,\"output_bytes\":%zu}",
+            r->best, r->median, r->user, r->sys, r->max_rss, r->bytes);
+}
+
+int main(int argc, char** argv){
+    if(argc < 4){
+        fprintf(stderr, "usage: %s ROOT MYLS OUT.json [RUNS]\n", argv[0]);
+        return 1;
+    }
+    const char* root = argv[1];
+    const char* myls = argv[2];
+    const char* out_path = argv[3];
+    int runs = argc > 4 ? atoi(argv[4]) : 3;
+    if(runs < 1)
+        runs = 1;
+
+    setenv("LC_ALL", "C", 1);
+    setenv("COLUMNS", "80", 1);
+    char* gnu = gnu_ls_version();
+    if(!gnu)
+        fprintf(stderr, "run_bench: `ls` is not GNU coreutils, timing myls only\n");
+
+    FILE* out = fopen(out_path, "w");
+    if(!out){
+        perror(out_path);
+        return 1;
+    }
+    time_t now = time(NULL);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    fprintf(out, "{\"date\":\"%s\",\"root\":", date);
+    json_string(out, root);
+    fprintf(out, ",\"runs\":%d,\"cpus\":%ld,\"gnu_ls\":", runs, sysconf(_SC_NPROCESSORS_ONLN));
+    if(gnu)
+        json_string(out, gnu);
+    else
+        fprintf(out, "null");
+    fprintf(out, ",\"results\":[");
+
+    printf("%-12s %-15s %11s %11s %8s  %s\n", "tree", "options", "myls (ms)", "ls (ms)", "speedup", "output");
+    bool first = true;
+    int mismatches = 0;
+    for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i){
+        const bench_case_t* c = &cases[i];
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", root, c->tree);
+        struct stat st;
+        if(stat(path, &st) || !S_ISDIR(st.st_mode))
+            continue;
+
+        char* args[MAX_ARGS];
+        char buf[256];
+        build_argv(args, buf, sizeof(buf), myls, c->myls, path);
+        run_result_t mine = measure(args, runs);
+        run_result_t theirs;
+        memset(&theirs, 0, sizeof(theirs));
+        if(gnu && c->gnu){
+            build_argv(args, buf, sizeof(buf), "ls", c->gnu, path);
+            theirs = measure(args, runs);
+        }
+
+        const char* match = "-";
+        if(mine.ok && theirs.ok){
+            match = mine.hash == theirs.hash && mine.bytes == theirs.bytes ? "same" : "DIFFERS";
+            mismatches += match[0] == 'D';
+        }
+        printf("%-12s %-15s", c->tree, c->myls[0] ? c->myls : "(default)");
+        if(mine.ok)
+            printf(" %11.2f", mine.median);
+        else
+            printf(" %11s", "failed");
+        if(theirs.ok)
+            printf(" %11.2f %7.2fx", theirs.median, theirs.median / mine.median);
+        else
+            printf(" %11s %8s", "-", "-");
+        printf("  %s\n", match);
+        fflush(stdout);
+
+        fprintf(out, "%s\n{\"tree\":\"%s\",\"options\":\"%s\",\"gnu_options\":", first ? "" : ",", c->tree, c->myls);
+        if(c->gnu && gnu)
+            fprintf(out, "\"%s\"", c->gnu);
+        else
+            fprintf(out, "null");
+        json_result(out, "myls", &mine);
+        if(c->gnu && gnu){
+            json_result(out, "gnu", &theirs);
+            if(mine.ok && theirs.ok)
+                fprintf(out, ",\"speedup\":%.3f,\"same_output\":%s", theirs.median / mine.median,
+                        match[0] == 's' ? "true" : "false");
+        }
+        fprintf(out, "}");
+        first = false;
+    }
+    fprintf(out, "\n]}\n");
+    int failed = ferror(out);
+    if(fclose(out) || failed){
+        perror(out_path);
+        return 1;
+    }
+    printf("results written to %s\n", out_path);
+    if(mismatches)
+        fprintf(stderr, "run_bench: %d case(s) printed different output than ls\n", mismatches);
+    free(gnu);
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * sort_bench
+ * ----------
+ * Compare the original record sort (qsort over file_info_t records with an
+ * inline name[PATH_MAX]) against sort_file_list(), which sorts compact
+ * sort_key_t records and stores a permutation.
+ *
+ * Usage:
+ *   ./bench/sort_bench [ENTRIES] [RUNS]
+ *
+ * Behavior:
+ *   - Generates ENTRIES (default 100000) in-memory entries with dated log
+ *     style names and random mtimes (with some exact ties)
+ *   - Sorts them RUNS times (default 5) per mode (-t and name order),
+ *     starting from the same unsorted input each time
+ *   - Reports the best time per implementation and the speedup
+ *   - The legacy records take about 8 KB of memory per entry
+ */
+
+#include "bench.h"
+
+// record layout used before the arena-backed entry store
+typedef struct{
+    char name[PATH_MAX];
+    long sec;
+    long nsec;
+    bool is_dir;
+}legacy_info_t;
+
+static int legacy_cmp_time(const void *a, const void *b){
+    const legacy_info_t *fa = a;
+    const legacy_info_t *fb = b;
+    if (fa->sec < fb->sec) return 1;
+    if (fa->sec > fb->sec) return -1;
+    if (fa->nsec < fb->nsec) return 1;
+    if (fa->nsec > fb->nsec) return -1;
+    return strcmp(fa->name, fb->name);
+}
+
+static int legacy_cmp_lex(const void *a, const void *b){
+    const legacy_info_t *fa = a;
+    const legacy_info_t *fb = b;
+    return strcmp(fa->name, fb->name);
+}
+
+int main(int argc, char** argv){
+    int entries = argc > 1 ? atoi(argv[1]) : 100000;
+    int runs = argc > 2 ? atoi(argv[2]) : 5;
+
+    // generate input once
+    file_list_t input;
+    file_list_init(&input);
+    srand(42);
+    for(int i = 0; i < entries; ++i){
+        char name[64];
+        int len = snprintf(name, sizeof(name), "app-2024-%02d-%02d-%06d.log",
+                           rand() % 12 + 1, rand() % 28 + 1, rand() % 1000000);
+        file_info_t* info = file_list_add(&input, name, (size_t)len);
+        info->sec = 1700000000L + rand() % 1000000;
+        info->nsec = (i % 10 == 0) ? 0 : rand() % 1000000000L;
+    }
+
+    legacy_info_t* legacy_in = xmalloc((size_t)entries * sizeof(legacy_info_t));
+    legacy_info_t* legacy = xmalloc((size_t)entries * sizeof(legacy_info_t));
+    for(int i = 0; i < entries; ++i){
+        strcpy(legacy_in[i].name, input.files[i].name);
+        legacy_in[i].sec = input.files[i].sec;
+        legacy_in[i].nsec = input.files[i].nsec;
+        legacy_in[i].is_dir = false;
+    }
+
+    for(int mode = 0; mode < 2; ++mode){
+        bool by_time = mode == 0;
+        double best_legacy = 1e30, best_keys = 1e30;
+
+        for(int r = 0; r < runs; ++r){
+            memcpy(legacy, legacy_in, (size_t)entries * sizeof(legacy_info_t));
+            double t0 = now_sec();
+            qsort(legacy, entries, sizeof(legacy_info_t), by_time ? legacy_cmp_time : legacy_cmp_lex);
+            double dt = now_sec() - t0;
+            if(dt < best_legacy)
+                best_legacy = dt;
+
+            free(input.order);
+            input.order = NULL;
+            t0 = now_sec();
+            sort_file_list(&input, by_time);
+            dt = now_sec() - t0;
+            if(dt < best_keys)
+                best_keys = dt;
+        }
+
+        // both must agree on the resulting order
+        for(int i = 0; i < entries; ++i)
+            if(strcmp(legacy[i].name, file_list_at(&input, i)->name)){
+                fprintf(stderr, "order mismatch at %d\n", i);
+                return 1;
+            }
+
+        printf("%-6s %8d entries  records %9.3f ms  keys %9.3f ms  speedup %5.1fx\n",
+               by_time ? "-t" : "name", entries, best_legacy * 1e3, best_keys * 1e3,
+               best_legacy / best_keys);
+    }
+
+    free(legacy_in);
+    free(legacy);
+    file_list_free(&input);
+    return 0;
+}
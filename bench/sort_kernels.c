@@ -0,0 +1,219 @@
+/*
+ * sort_kernels
+ * ------------
+ * Microbenchmark of the comparators and sort kernels of sort.c on
+ * in-memory entry sets, free of filesystem noise.
+ *
+ * Usage:
+ *   ./bench/sort_kernels [ENTRIES] [RUNS]
+ *
+ * Behavior:
+ *   - Builds ENTRIES (default 100000) entries for each set:
+ *       random   - random names and mtimes
+ *       sorted   - the random set, already in display order
+ *       reverse  - the random set, in reverse display order
+ *       ties     - 8 distinct mtimes, so names decide almost every order
+ *       shared   - 16 groups of names sharing a 40-byte prefix, which the
+ *                  packed 8-byte key prefix cannot tell apart
+ *   - Sorts every set by name and by -t with each kernel, RUNS times
+ *     (default 5) from the same input:
+ *       strcmp     - qsort with plain strcmp()/mtime comparators (the
+ *                    comparators before prefix-packed keys)
+ *       prefix     - qsort with cmp_file_lex()/cmp_file_time()
+ *       radix      - radix_sort_time() (-t only)
+ *       file_list  - sort_file_list(), key building included
+ *   - Checks every kernel against strcmp and reports the best time,
+ *     ns/element and comparator calls/element
+ *
+ * Notes:
+ *   - Includes sort.c to reach its static kernels, with SORT_COUNT_CMP()
+ *     counting comparator calls; the binary is linked without sort.o
+ */
+
+#include "bench.h"
+
+static uint64_t compares;
+#define SORT_COUNT_CMP() (compares++)
+#include "../sort.c"
+
+enum{ SET_RANDOM, SET_SORTED, SET_REVERSE, SET_TIES, SET_SHARED, SETS };
+
+static const char* set_names[SETS] = {"random", "sorted", "reverse", "ties", "shared"};
+
+static int strcmp_lex(const void *a, const void *b){
+    compares++;
+    return strcmp(((const sort_key_t*)a)->name, ((const sort_key_t*)b)->name);
+}
+
+static int strcmp_time(const void *a, const void *b){
+    const sort_key_t *fa = a;
+    const sort_key_t *fb = b;
+    compares++;
+    if (fa->sec != fb->sec) return fa->sec < fb->sec ? 1 : -1;
+    if (fa->nsec != fb->nsec) return fa->nsec < fb->nsec ? 1 : -1;
+    return strcmp(fa->name, fb->name);
+}
+
+static void run_strcmp(file_list_t* flist, sort_key_t* keys, bool sort_time){
+    qsort(keys, flist->count, sizeof(sort_key_t), sort_time ? strcmp_time : strcmp_lex);
+}
+
+static void run_prefix(file_list_t* flist, sort_key_t* keys, bool sort_time){
+    qsort(keys, flist->count, sizeof(sort_key_t), sort_time ? cmp_file_time : cmp_file_lex);
+}
+
+static void run_radix(file_list_t* flist, sort_key_t* keys, bool sort_time){
+    (void)sort_time;
+    radix_sort_time(keys, flist->count);
+}
+
+static void run_file_list(file_list_t* flist, sort_key_t* keys, bool sort_time){
+    (void)keys;
+    sort_file_list(flist, sort_time);
+}
+
+/*
+ * kernel_t
+ * --------
+ * One sort implementation.
+ *
+ * Fields:
+ *   name      - label in the report
+ *   full_name - sorts keys with the whole name (no common prefix skipped)
+ *   time_only - only meaningful for -t
+ *   run       - sort keys (or the list itself) in place
+ */
+typedef struct{
+    const char* name;
+    bool full_name;
+    bool time_only;
+    void (*run)(file_list_t*, sort_key_t*, bool);
+}kernel_t;
+
+static const kernel_t kernels[] = {
+    {"strcmp", true, false, run_strcmp},
+    {"prefix", false, false, run_prefix},
+    {"radix", false, true, run_radix},
+    {"file_list", false, false, run_file_list},
+};
+
+static void random_name(char* buf, int set){
+    static const char chars[] = "abcdefghijklmnopqrstuvwxyz0123456789_-.";
+    int pos = 0;
+    if(set == SET_SHARED)
+        pos = snprintf(buf, 48, "%c_%s", 'a' + rand() % 16, "shared_component_of_a_long_build_path_");
+    int len = pos + 6 + rand() % 16;
+    while(pos < len)
+        buf[pos++] = chars[rand() % (sizeof(chars) - 1)];
+    buf[pos] = '\0';
+}
+
+/*
+ * build_set
+ * ---------
+ * Fill flist with the entries of a set, laid out in the set's input order
+ * for the given sort mode.
+ */
+static void build_set(file_list_t* flist, int set, int entries, bool sort_time){
+    srand(4321 + set);
+    file_list_t tmp;
+    file_list_init(&tmp);
+    for(int i = 0; i < entries; ++i){
+        char name[128];
+        random_name(name, set);
+        file_info_t* info = file_list_add(&tmp, name, strlen(name));
+        if(set == SET_TIES){
+            info->sec = 1700000000 - rand() % 8;
+            info->nsec = 0;
+        }
+        else{
+            info->sec = 1700000000 - rand() % (365 * 86400);
+            info->nsec = rand() % 1000000000;
+        }
+    }
+    if(set == SET_SORTED || set == SET_REVERSE)
+        sort_file_list(&tmp, sort_time);
+
+    file_list_init(flist);
+    for(int i = 0; i < entries; ++i){
+        int pos = set == SET_REVERSE ? entries - 1 - i : i;
+        const file_info_t* src = file_list_at(&tmp, pos);
+        file_info_t* info = file_list_add(flist, src->name, strlen(src->name));
+        info->sec = src->sec;
+        info->nsec = src->nsec;
+    }
+    file_list_free(&tmp);
+}
+
+// entries at display position i of both orders must be indistinguishable
+static bool same_order(const file_list_t* flist, const uint32_t* a, const uint32_t* b){
+    for(int i = 0; i < flist->count; ++i){
+        const file_info_t* x = &flist->files[a[i]];
+        const file_info_t* y = &flist->files[b[i]];
+        if(strcmp(x->name, y->name) || x->sec != y->sec || x->nsec != y->nsec)
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv){
+    int entries = argc > 1 ? atoi(argv[1]) : 100000;
+    int runs = argc > 2 ? atoi(argv[2]) : 5;
+    if(entries < 1 || runs < 1){
+        fprintf(stderr, "usage: %s [ENTRIES] [RUNS]\n", argv[0]);
+        return 1;
+    }
+    int nkernels = (int)(sizeof(kernels) / sizeof(kernels[0]));
+
+    printf("%-8s %-5s %-10s %10s %10s %10s\n", "set", "order", "kernel", "best ms", "ns/elem", "cmp/elem");
+    for(int set = 0; set < SETS; ++set){
+        for(int mode = 0; mode < 2; ++mode){
+            bool sort_time = mode == 1;
+            file_list_t flist;
+            build_set(&flist, set, entries, sort_time);
+
+            sort_key_t* full = build_sort_keys(&flist);
+            for(int i = 0; i < entries; ++i)
+                full[i].name = flist.files[i].name;
+            sort_key_t* packed = build_sort_keys(&flist);
+            sort_key_t* keys = xmalloc((size_t)entries * sizeof(sort_key_t));
+            uint32_t* reference = xmalloc((size_t)entries * sizeof(uint32_t));
+            uint32_t* order = xmalloc((size_t)entries * sizeof(uint32_t));
+
+            for(int k = 0; k < nkernels; ++k){
+                const kernel_t* kernel = &kernels[k];
+                if(kernel->time_only && !sort_time)
+                    continue;
+                double best = 1e30;
+                for(int r = 0; r < runs; ++r){
+                    memcpy(keys, kernel->full_name ? full : packed, (size_t)entries * sizeof(sort_key_t));
+                    compares = 0;
+                    double t0 = now_sec();
+                    kernel->run(&flist, keys, sort_time);
+                    double dt = now_sec() - t0;
+                    if(dt < best)
+                        best = dt;
+                }
+
+                for(int i = 0; i < entries; ++i)
+                    order[i] = kernel->run == run_file_list ? flist.order[i] : keys[i].index;
+                if(k == 0)
+                    memcpy(reference, order, (size_t)entries * sizeof(uint32_t));
+                else if(!same_order(&flist, reference, order)){
+                    fprintf(stderr, "%s/%s: %s order differs from strcmp\n",
+                            set_names[set], sort_time ? "time" : "name", kernel->name);
+                    return 1;
+                }
+                printf("%-8s %-5s %-10s %10.3f %10.1f %10.2f\n", set_names[set], sort_time ? "time" : "name",
+                       kernel->name, best * 1e3, best * 1e9 / entries, (double)compares / entries);
+            }
+            free(order);
+            free(reference);
+            free(keys);
+            free(packed);
+            free(full);
+            file_list_free(&flist);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * stat_bench
+ * ----------
+ * Compare the stat engines used by read_directory() on one directory:
+ * the synchronous stat_entry() loop, batched io_uring statx and the
+ * --jobs worker pool.
+ *
+ * Usage:
+ *   ./bench/stat_bench DIR [ENTRIES] [RUNS] [JOBS]
+ *
+ * Behavior:
+ *   - Populates DIR with ENTRIES empty files (default 100000) if needed
+ *   - Collects the names once, then stats the whole list RUNS times
+ *     (default 5) with each engine, requesting type and mtime as -t does
+ *   - Reports the best wall time and ns/entry per engine; run it on
+ *     different filesystems (e.g. tmpfs and ext4) to compare them
+ */
+
+#include "bench.h"
+
+static double time_sync(int dfd, file_list_t* flist){
+    double t0 = now_sec();
+    for(int i = 0; i < flist->count; ++i)
+        stat_entry(dfd, flist->files[i].name, STAT_NEED_TYPE | STAT_NEED_MTIME, &flist->files[i]);
+    return now_sec() - t0;
+}
+
+static double time_uring(int dfd, file_list_t* flist){
+    double t0 = now_sec();
+    if(uring_stat_run(dfd, flist, STAT_NEED_TYPE | STAT_NEED_MTIME))
+        return -1;
+    return now_sec() - t0;
+}
+
+static double time_pool(int dfd, file_list_t* flist){
+    double t0 = now_sec();
+    stat_pool_run(dfd, flist, STAT_NEED_TYPE | STAT_NEED_MTIME);
+    return now_sec() - t0;
+}
+
+static void report(const char* label, double (*run)(int, file_list_t*),
+                   int dfd, file_list_t* flist, int runs){
+    double best = 1e30;
+    for(int r = 0; r < runs; ++r){
+        double dt = run(dfd, flist);
+        if(dt < 0){
+            printf("%-16s unavailable\n", label);
+            return;
+        }
+        if(dt < best)
+            best = dt;
+    }
+    printf("%-16s %10d entries %9.3f ms %7.1f ns/entry\n",
+           label, flist->count, best * 1e3, best * 1e9 / flist->count);
+}
+
+int main(int argc, char** argv){
+    if(argc < 2){
+        fprintf(stderr, "usage: %s DIR [ENTRIES] [RUNS] [JOBS]\n", argv[0]);
+        return 1;
+    }
+    const char* path = argv[1];
+    size_t entries = argc > 2 ? strtoull(argv[2], NULL, 10) : 100000;
+    int runs = argc > 3 ? atoi(argv[3]) : 5;
+    int jobs = argc > 4 ? atoi(argv[4]) : 8;
+
+    populate_dir(path, entries);
+
+    file_list_t flist;
+    file_list_init(&flist);
+    dir_reader_t reader;
+    if(dir_reader_open(&reader, path, 0)){
+        perror(path);
+        return 1;
+    }
+    dir_entry_t e;
+    while(dir_reader_next(&reader, &e) > 0)
+        file_list_add(&flist, e.name, e.len);
+
+    report("sync statx", time_sync, reader.fd, &flist, runs);
+
+    if(uring_start())
+        printf("%-16s unavailable\n", "io_uring");
+    else{
+        report("io_uring", time_uring, reader.fd, &flist, runs);
+        uring_stop();
+    }
+
+    stat_pool_start(jobs);
+    char label[32];
+    snprintf(label, sizeof(label), "pool --jobs %d", jobs);
+    report(label, time_pool, reader.fd, &flist, runs);
+    stat_pool_stop();
+
+    dir_reader_close(&reader);
+    file_list_free(&flist);
+    return 0;
+}
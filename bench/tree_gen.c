@@ -0,0 +1,272 @@
+/*
+ * tree_gen
+ * --------
+ * Build the reproducible directory trees used by `make bench`.
+ *
+ * Usage:
+ *   ./bench/tree_gen ROOT [FLAT_MAX]
+ *
+ * Behavior:
+ *   - Creates under ROOT (normally on tmpfs, so the disk is not measured):
+ *       flat-1k, flat-100k, flat-1m - flat directories of that many entries
+ *                                     (only sizes up to FLAT_MAX, default
+ *                                     1000000): mixed name lengths, ~10%
+ *                                     hidden, ~5% subdirectories
+ *       deep        - a chain of 256 nested directories, 8 files per level
+ *       tree        - fanout 8, depth 4 (4680 directories), 24 files each
+ *       long-names  - 20000 names of 180-255 bytes sharing long prefixes
+ *       mixed-mtime - 100000 files whose mtimes repeat heavily: shared
+ *                     seconds with distinct nanoseconds, exact duplicates,
+ *                     a spread over three years and some future times
+ *   - Names and timestamps come from a fixed-seed generator and a fixed
+ *     base time, so every run builds identical trees
+ *     (directory mtimes included)
+ *   - A finished tree is marked with ROOT/.NAME.done and skipped next
+ *     time; an interrupted one is completed in place
+ */
+
+#include "bench.h"
+#include<sys/time.h>
+
+#define BASE_TIME 1700000000L
+
+static uint64_t rng_state;
+
+// splitmix64: small, fast and identical on every platform
+static uint64_t rng(void){
+    uint64_t z = (rng_state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static void die(const char* what){
+    perror(what);
+    exit(1);
+}
+
+static int open_dir(int parent, const char* name){
+    if(mkdirat(parent, name, 0755) && errno != EEXIST)
+        die(name);
+    int fd = openat(parent, name, O_RDONLY | O_DIRECTORY);
+    if(fd < 0)
+        die(name);
+    return fd;
+}
+
+static void set_mtime(int dfd, const char* name, long sec, long nsec){
+    struct timespec ts[2] = {{sec, nsec}, {sec, nsec}};
+    if(utimensat(dfd, name, ts, AT_SYMLINK_NOFOLLOW))
+        die(name);
+}
+
+static void make_file(int dfd, const char* name, long sec, long nsec){
+    int fd = openat(dfd, name, O_CREAT | O_WRONLY, 0644);
+    if(fd < 0)
+        die(name);
+    close(fd);
+    set_mtime(dfd, name, sec, nsec);
+}
+
+// random name of len characters (buf holds len + 1), unique through the
+// base-36 suffix of i
+static void random_name(char* buf, size_t len, size_t i, bool hidden){
+    static const char chars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789._-";
+    char suffix[16];
+    int n = 0;
+    do{
+        suffix[n++] = "0123456789abcdefghijklmnopqrstuvwxyz"[i % 36];
+        i /= 36;
+    }while(i);
+    size_t pos = 0;
+    if(hidden)
+        buf[pos++] = '.';
+    while(pos + (size_t)n + 1 < len)
+        buf[pos++] = chars[rng() % (sizeof(chars) - 1)];
+    buf[pos++] = '~';
+    while(n > 0)
+        buf[pos++] = suffix[--n];
+    buf[pos] = '\0';
+}
+
+static bool tree_done(int root, const char* name){
+    char marker[64];
+    snprintf(marker, sizeof(marker), ".%s.done", name);
+    struct stat st;
+    if(!fstatat(root, marker, &st, 0))
+        return true;
+    fprintf(stderr, "tree_gen: building %s...\n", name);
+    rng_state = 0;
+    for(const char* p = name; *p; ++p)
+        rng_state = rng_state * 131 + (unsigned char)*p;
+    return false;
+}
+
+// pin the tree's own mtime (filling it changed it) and write the marker
+static void mark_done(int root, const char* name){
+    set_mtime(root, name, BASE_TIME, 0);
+    char marker[64];
+    snprintf(marker, sizeof(marker), ".%s.done", name);
+    make_file(root, marker, BASE_TIME, 0);
+}
+
+static void gen_flat(int root, const char* name, size_t entries){
+    if(tree_done(root, name))
+        return;
+    int dfd = open_dir(root, name);
+    char buf[64];
+    for(size_t i = 0; i < entries; ++i){
+        uint64_t r = rng();
+        random_name(buf, 4 + r % 28, i, r % 10 == 0);
+        long sec = BASE_TIME - (long)(rng() % (400L * 86400));
+        if((r >> 8) % 20 == 0){
+            if(mkdirat(dfd, buf, 0755) && errno != EEXIST)
+                die(buf);
+            set_mtime(dfd, buf, sec, 0);
+        }
+        else
+            make_file(dfd, buf, sec, (long)(rng() % 1000000000));
+    }
+    close(dfd);
+    mark_done(root, name);
+}
+
+static void gen_level(int dfd, int level){
+    char name[32];
+    for(int f = 0; f < 8; ++f){
+        snprintf(name, sizeof(name), "file-%d", f);
+        make_file(dfd, name, BASE_TIME - level * 3600L - f, 0);
+    }
+    if(level == 256)
+        return;
+    snprintf(name, sizeof(name), "level-%03d", level);
+    int sub = open_dir(dfd, name);
+    gen_level(sub, level + 1);
+    close(sub);
+    set_mtime(dfd, name, BASE_TIME - level * 3600L, 0);
+}
+
+static void gen_deep(int root){
+    if(tree_done(root, "deep"))
+        return;
+    int dfd = open_dir(root, "deep");
+    gen_level(dfd, 0);
+    close(dfd);
+    mark_done(root, "deep");
+}
+
+static void gen_subtree(int dfd, int depth){
+    char name[64];
+    for(int f = 0; f < 24; ++f){
+        random_name(name, 6 + rng() % 16, (size_t)f, f == 0);
+        make_file(dfd, name, BASE_TIME - (long)(rng() % (90L * 86400)), (long)(rng() % 1000000000));
+    }
+    if(depth == 0)
+        return;
+    for(int d = 0; d < 8; ++d){
+        snprintf(name, sizeof(name), "dir-%d", d);
+        int sub = open_dir(dfd, name);
+        gen_subtree(sub, depth - 1);
+        close(sub);
+        set_mtime(dfd, name, BASE_TIME - depth * 86400L - d, 0);
+    }
+}
+
+static void gen_tree(int root){
+    if(tree_done(root, "tree"))
+        return;
+    int dfd = open_dir(root, "tree");
+    for(int d = 0; d < 8; ++d){
+        char name[16];
+        snprintf(name, sizeof(name), "dir-%d", d);
+        int sub = open_dir(dfd, name);
+        gen_subtree(sub, 3);
+        close(sub);
+        set_mtime(dfd, name, BASE_TIME - d, 0);
+    }
+    close(dfd);
+    mark_done(root, "tree");
+}
+
+static void gen_long_names(int root){
+    if(tree_done(root, "long-names"))
+        return;
+    int dfd = open_dir(root, "long-names");
+    // 40 groups sharing a 150-byte prefix: comparisons must scan it
+    char prefixes[40][151];
+    for(int g = 0; g < 40; ++g)
+        random_name(prefixes[g], 150, (size_t)g, false);
+    char name[256];
+    for(size_t i = 0; i < 20000; ++i){
+        size_t len = 180 + rng() % 76;
+        memcpy(name, prefixes[rng() % 40], 150);
+        random_name(name + 150, len - 150, i, false);
+        make_file(dfd, name, BASE_TIME - (long)(rng() % (30L * 86400)), (long)(rng() % 1000000000));
+    }
+    close(dfd);
+    mark_done(root, "long-names");
+}
+
+static void gen_mixed_mtime(int root){
+    if(tree_done(root, "mixed-mtime"))
+        return;
+    int dfd = open_dir(root, "mixed-mtime");
+    char name[64];
+    for(size_t i = 0; i < 100000; ++i){
+        uint64_t r = rng() % 100;
+        long sec, nsec;
+        if(r < 40){
+            // one of 100 shared seconds, distinct nanoseconds
+            sec = BASE_TIME - (long)(rng() % 100) * 86400;
+            nsec = (long)(rng() % 1000000000);
+        }
+        else if(r < 60){
+            // exact duplicates: the name decides the order
+            sec = BASE_TIME - (long)(rng() % 10) * 3600;
+            nsec = 500000000;
+        }
+        else if(r < 95){
+            sec = BASE_TIME - (long)(rng() % (3L * 365 * 86400));
+            nsec = (long)(rng() % 1000000000);
+        }
+        else{
+            // future timestamps
+            sec = BASE_TIME + (long)(rng() % (5L * 365 * 86400));
+            nsec = 0;
+        }
+        random_name(name, 8 + rng() % 16, i, false);
+        make_file(dfd, name, sec, nsec);
+    }
+    close(dfd);
+    mark_done(root, "mixed-mtime");
+}
+
+int main(int argc, char** argv){
+    if(argc < 2){
+        fprintf(stderr, "usage: %s ROOT [FLAT_MAX]\n", argv[0]);
+        return 1;
+    }
+    size_t flat_max = argc > 2 ? strtoull(argv[2], NULL, 10) : 1000000;
+
+    if(mkdir(argv[1], 0755) && errno != EEXIST)
+        die(argv[1]);
+    int root = open(argv[1], O_RDONLY | O_DIRECTORY);
+    if(root < 0)
+        die(argv[1]);
+
+    static const struct{
+        const char* name;
+        size_t entries;
+    }flat[] = {{"flat-1k", 1000}, {"flat-100k", 100000}, {"flat-1m", 1000000}};
+    for(size_t i = 0; i < sizeof(flat) / sizeof(flat[0]); ++i)
+        if(flat[i].entries <= flat_max)
+            gen_flat(root, flat[i].name, flat[i].entries);
+    gen_deep(root);
+    gen_tree(root);
+    gen_long_names(root);
+    gen_mixed_mtime(root);
+    struct timespec ts[2] = {{BASE_TIME, 0}, {BASE_TIME, 0}};
+    futimens(root, ts);
+    close(root);
+    return 0;
+}
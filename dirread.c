@@ -0,0 +1,168 @@
+/*
+ * Directory Reader
+ * ----------------
+ * Batched directory enumeration used by read_directory().
+ *
+ * On Linux, entries are fetched with the raw getdents64 system call into a
+ * large per-thread buffer (DIRENT_BUF_SIZE bytes by default) that is reused
+ * for every directory read by that thread. Entries are parsed in place, so
+ * names are handed to the caller as pointers into the buffer rather than
+ * copies. Other systems fall back to opendir()/readdir() behind the same
+ * interface.
+ */
+
+#include "myls.h"
+
+#ifdef __linux__
+#include<unistd.h>
+#include<sys/syscall.h>
+
+/*
+ * linux_dirent64
+ * --------------
+ * Record layout returned by getdents64 (see getdents(2)).
+ */
+struct linux_dirent64{
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+#endif
+
+static __thread char* tls_buf = NULL;
+static __thread size_t tls_cap = 0;
+
+/*
+ * dir_buffer_get
+ * --------------
+ * Return the calling thread's reusable getdents buffer, allocating it on
+ * first use or growing it when a larger size is requested.
+ *
+ * Parameters:
+ *   size - minimum buffer size in bytes; 0 selects DIRENT_BUF_SIZE
+ *   cap  - output: actual size of the returned buffer
+ */
+char* dir_buffer_get(size_t size, size_t* cap){
+    if(size == 0)
+        size = DIRENT_BUF_SIZE;
+    if(tls_cap < size){
+        free(tls_buf);
+        tls_buf = xmalloc(size);
+        tls_cap = size;
+    }
+    *cap = tls_cap;
+    return tls_buf;
+}
+
+/*
+ * dir_buffer_release
+ * ------------------
+ * Free the calling thread's getdents buffer. Worker threads call this
+ * before exiting; the main thread may simply let it live until exit.
+ */
+void dir_buffer_release(void){
+    free(tls_buf);
+    tls_buf = NULL;
+    tls_cap = 0;
+}
+
+/*
+ * dir_reader_open
+ * ---------------
+ * Open a directory for batched enumeration.
+ *
+ * Parameters:
+ *   reader   - reader state to initialise
+ *   path     - directory to open
+ *   buf_size - getdents buffer size in bytes; 0 selects DIRENT_BUF_SIZE
+ *
+ * Returns:
+ *   0 on success, -1 if the directory could not be opened (errno is set).
+ */
+int dir_reader_open(dir_reader_t* reader, const char* path, size_t buf_size){
+#ifdef __linux__
+    uint64_t start = stats_call_begin();
+    reader->fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    stats_call_end(STATS_SYS_OPEN, start, NULL);
+    if(reader->fd < 0)
+        return -1;
+    reader->buf = dir_buffer_get(buf_size, &reader->cap);
+    reader->pos = 0;
+    reader->len = 0;
+#else
+    (void)buf_size;
+    uint64_t start = stats_call_begin();
+    reader->dir = opendir(path);
+    stats_call_end(STATS_SYS_OPEN, start, NULL);
+    if(!reader->dir)
+        return -1;
+    reader->fd = dirfd(reader->dir);
+#endif
+    return 0;
+}
+
+/*
+ * dir_reader_next
+ * ---------------
+ * Fetch the next entry of an open directory.
+ *
+ * Parameters:
+ *   reader - open reader
+ *   out    - receives the entry name, its length and its d_type
+ *
+ * Returns:
+ *   1 if an entry was produced, 0 at end of directory, -1 on error.
+ *
+ * Notes:
+ *   - out->name points into the reader's buffer and is only valid until
+ *     the next call to dir_reader_next() or dir_reader_close()
+ *   - A new batch is requested from the kernel only when the current
+ *     buffer has been fully consumed
+ */
+int dir_reader_next(dir_reader_t* reader, dir_entry_t* out){
+#ifdef __linux__
+    if(reader->pos >= reader->len){
+        uint64_t start = stats_call_begin();
+        long n = syscall(SYS_getdents64, reader->fd, reader->buf, reader->cap);
+        stats_call_end(STATS_SYS_GETDENTS, start, NULL);
+        if(n < 0)
+            return -1;
+        if(n == 0)
+            return 0;
+        reader->len = (size_t)n;
+        reader->pos = 0;
+    }
+
+    struct linux_dirent64* d = (struct linux_dirent64*)(reader->buf + reader->pos);
+    reader->pos += d->d_reclen;
+    out->name = d->d_name;
+    out->len = strlen(d->d_name);
+    out->type = d->d_type;
+    return 1;
+#else
+    errno = 0;
+    struct dirent* d = readdir(reader->dir);
+    if(!d)
+        return errno ? -1 : 0;
+    out->name = d->d_name;
+    out->len = strlen(d->d_name);
+    out->type = d->d_type;
+    return 1;
+#endif
+}
+
+/*
+ * dir_reader_close
+ * ----------------
+ * Close the directory. The shared buffer is kept for the next reader.
+ */
+void dir_reader_close(dir_reader_t* reader){
+#ifdef __linux__
+    close(reader->fd);
+#else
+    closedir(reader->dir);
+#endif
+    reader->fd = -1;
+}
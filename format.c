@@ -0,0 +1,702 @@
+/*
+ * Entry Formatting
+ * ----------------
+ * Printing of directory listings and file operands: one name per line, or
+ * with -l one entry per line in the long format
+ *
+ *     drwxr-xr-x 2 owner group 4096 Mar 17 08:15 name
+ *     lrwxrwxrwx 1 owner group    6 Mar 17 08:15 link -> target
+ *
+ * Column widths are measured over the whole listing first, as GNU ls does,
+ * then every row is written through the output buffer: numbers with
+ * out_uint(), strings with out_write(), so no format string is parsed per
+ * entry.
+ *
+ * getpwuid() / getgrgid() may go through NSS (files, LDAP, ...) on every
+ * call, so owner and group names are resolved once per distinct id and
+ * kept in a small open-addressing hash table for the rest of the run.
+ * Formatting only ever happens on the printing thread, so the caches are
+ * not locked.
+ *
+ * The time column is the other hot spot: localtime_r() + strftime() per
+ * entry. Dates are cached per local day (see day_lookup()) and the time
+ * of day is derived arithmetically, so both run once per distinct day.
+ *
+ * -C / -x choose the largest number of columns that fits the terminal,
+ * with GNU ls's rules. Every entry carries its display width (computed
+ * once by file_list_add()), and candidates are first rejected with an
+ * O(1) bound, so typically only one or two layouts are measured.
+ */
+
+#include "myls.h"
+#include<pwd.h>
+#include<grp.h>
+#include<time.h>
+#include<sys/sysmacros.h>
+
+#define ID_CACHE_INITIAL 64
+#define SIX_MONTHS (31556952 / 2) // half an average Gregorian year, as GNU ls
+#define DAY_CACHE_SLOTS 64         // distinct days kept for the time column
+#define MIN_COLUMN_WIDTH 3         // one character and the two-space gap
+#define TAB_SIZE 8                 // -C / -x pad with tabs, like GNU ls
+
+/*
+ * id_slot_t / id_cache_t
+ * ----------------------
+ * uid -> name or gid -> name hash table with linear probing.
+ *
+ * Fields:
+ *   slots - power-of-two sized slot array, kept at most half full
+ *   group - resolve ids with getgrgid() instead of getpwuid()
+ */
+typedef struct{
+    uint32_t id;
+    bool used;
+    uint32_t len;
+    char* name;
+}id_slot_t;
+
+typedef struct{
+    id_slot_t* slots;
+    uint32_t cap;
+    uint32_t count;
+    bool group;
+}id_cache_t;
+
+static id_cache_t users = { .group = false };
+static id_cache_t groups = { .group = true };
+
+/*
+ * id_find
+ * -------
+ * Return the slot holding id, or the empty slot where it belongs.
+ */
+static id_slot_t* id_find(id_cache_t* cache, uint32_t id){
+    uint32_t mask = cache->cap - 1;
+    uint32_t i = (id * 2654435761u) & mask;
+    while(cache->slots[i].used && cache->slots[i].id != id)
+        i = (i + 1) & mask;
+    return &cache->slots[i];
+}
+
+static void id_grow(id_cache_t* cache){
+    id_slot_t* old = cache->slots;
+    uint32_t old_cap = cache->cap;
+    cache->cap = old_cap ? old_cap * 2 : ID_CACHE_INITIAL;
+    cache->slots = xmalloc((size_t)cache->cap * sizeof(id_slot_t));
+    memset(cache->slots, 0, (size_t)cache->cap * sizeof(id_slot_t));
+    for(uint32_t i = 0; i < old_cap; ++i)
+        if(old[i].used)
+            *id_find(cache, old[i].id) = old[i];
+    free(old);
+}
+
+/*
+ * id_name
+ * -------
+ * Return the cached name of a uid or gid, resolving it on first use.
+ *
+ * Returns:
+ *   The slot holding the name and its length. Ids without a passwd/group
+ *   entry are shown as their number, like GNU ls.
+ */
+static const id_slot_t* id_name(id_cache_t* cache, uint32_t id){
+    if(cache->count * 2 >= cache->cap)
+        id_grow(cache);
+    id_slot_t* slot = id_find(cache, id);
+    if(slot->used)
+        return slot;
+
+    const char* name = NULL;
+    if(cache->group){
+        struct group* gr = getgrgid(id);
+        if(gr)
+            name = gr->gr_name;
+    }
+    else{
+        struct passwd* pw = getpwuid(id);
+        if(pw)
+            name = pw->pw_name;
+    }
+    char num[16];
+    if(!name){
+        snprintf(num, sizeof(num), "%u", id);
+        name = num;
+    }
+
+    size_t len = strlen(name);
+    slot->name = xmalloc(len + 1);
+    memcpy(slot->name, name, len + 1);
+    slot->len = (uint32_t)len;
+    slot->id = id;
+    slot->used = true;
+    cache->count++;
+    return slot;
+}
+
+/*
+ * format_mode
+ * -----------
+ * Render st_mode as the 10-character "drwxr-xr-x" column.
+ */
+static void format_mode(uint32_t mode, char* out){
+    switch(mode & S_IFMT){
+    case S_IFDIR:  out[0] = 'd'; break;
+    case S_IFLNK:  out[0] = 'l'; break;
+    case S_IFCHR:  out[0] = 'c'; break;
+    case S_IFBLK:  out[0] = 'b'; break;
+    case S_IFIFO:  out[0] = 'p'; break;
+    case S_IFSOCK: out[0] = 's'; break;
+    default:       out[0] = '-'; break;
+    }
+    out[1] = (mode & S_IRUSR) ? 'r' : '-';
+    out[2] = (mode & S_IWUSR) ? 'w' : '-';
+    out[3] = (mode & S_ISUID) ? ((mode & S_IXUSR) ? 's' : 'S') : ((mode & S_IXUSR) ? 'x' : '-');
+    out[4] = (mode & S_IRGRP) ? 'r' : '-';
+    out[5] = (mode & S_IWGRP) ? 'w' : '-';
+    out[6] = (mode & S_ISGID) ? ((mode & S_IXGRP) ? 's' : 'S') : ((mode & S_IXGRP) ? 'x' : '-');
+    out[7] = (mode & S_IROTH) ? 'r' : '-';
+    out[8] = (mode & S_IWOTH) ? 'w' : '-';
+    out[9] = (mode & S_ISVTX) ? ((mode & S_IXOTH) ? 't' : 'T') : ((mode & S_IXOTH) ? 'x' : '-');
+}
+
+/*
+ * day_slot_t
+ * ----------
+ * One cached local calendar day for the -l time column.
+ *
+ * Fields:
+ *   start  - epoch second of local midnight
+ *   len    - length of the day in seconds; 0 marks an empty slot
+ *   prefix - "Mar 17 " as produced by strftime("%b %e ")
+ *   year   - " 2023", completing the column for older files
+ */
+typedef struct{
+    long start;
+    long len;
+    char prefix[32];
+    size_t prefix_len;
+    char year[16];
+    size_t year_len;
+}day_slot_t;
+
+static day_slot_t day_cache[DAY_CACHE_SLOTS];
+static long day_offset; // UTC offset of the last day cached, to pick slots
+
+static long floor_div(long a, long b){
+    return a / b - (a % b < 0);
+}
+
+/*
+ * day_lookup
+ * ----------
+ * Return the cached day containing sec, filling its slot on a miss.
+ *
+ * Returns:
+ *   The slot, or NULL if the day cannot be cached because its UTC offset
+ *   changes within it (a daylight saving switch) or localtime_r() fails.
+ *
+ * Notes:
+ *   - A miss costs three localtime_r() calls and one strftime(); every
+ *     further entry modified on the same day costs a few integer ops
+ */
+static const day_slot_t* day_lookup(long sec){
+    long day = floor_div(sec + day_offset, 86400);
+    day_slot_t* slot = &day_cache[(unsigned long)day % DAY_CACHE_SLOTS];
+    if(slot->len && sec >= slot->start && sec - slot->start < slot->len)
+        return slot;
+
+    time_t t = (time_t)sec;
+    struct tm tm;
+    if(!localtime_r(&t, &tm))
+        return NULL;
+    long start = sec - (tm.tm_hour * 3600L + tm.tm_min * 60L + tm.tm_sec);
+
+    // the day is only uniform if midnight and its last second share the offset
+    struct tm first, last;
+    time_t t_first = (time_t)start, t_last = (time_t)(start + 86399);
+    if(!localtime_r(&t_first, &first) || !localtime_r(&t_last, &last) ||
+       first.tm_gmtoff != tm.tm_gmtoff || last.tm_gmtoff != tm.tm_gmtoff ||
+       first.tm_hour || first.tm_min || first.tm_sec)
+        return NULL;
+
+    day_offset = tm.tm_gmtoff;
+    slot = &day_cache[(unsigned long)floor_div(start + day_offset, 86400) % DAY_CACHE_SLOTS];
+    slot->start = start;
+    slot->len = 86400;
+    slot->prefix_len = strftime(slot->prefix, sizeof(slot->prefix), "%b %e ", &tm);
+    slot->year_len = strftime(slot->year, sizeof(slot->year), " %Y", &tm);
+    if(!slot->prefix_len || !slot->year_len){
+        slot->len = 0;
+        return NULL;
+    }
+    return slot;
+}
+
+/*
+ * format_time
+ * -----------
+ * Render a modification time as "Mar 17 08:15" for files from the last
+ * six months and "Mar 17  2023" otherwise (future times count as old).
+ *
+ * Returns:
+ *   Number of bytes written to buf (at least 64 bytes).
+ *
+ * Behavior:
+ *   - Takes the date from the day cache and derives HH:MM from the
+ *     offset into the day, so localtime_r() and strftime() only run once
+ *     per distinct day instead of once per entry
+ *   - Falls back to localtime_r() + strftime() for days the cache
+ *     cannot hold
+ */
+static size_t format_time(long sec, long nsec, char* buf){
+    static struct timespec now;
+    static bool have_now = false;
+
+    // like GNU ls, re-read the clock once a file from the "future" is seen
+    if(!have_now || sec > now.tv_sec || (sec == now.tv_sec && nsec > now.tv_nsec)){
+        clock_gettime(CLOCK_REALTIME, &now);
+        have_now = true;
+    }
+    long old_sec = now.tv_sec - SIX_MONTHS;
+    bool recent = (sec > old_sec || (sec == old_sec && nsec > now.tv_nsec)) &&
+                  (sec < now.tv_sec || (sec == now.tv_sec && nsec < now.tv_nsec));
+
+    const day_slot_t* day = day_lookup(sec);
+    if(day){
+        memcpy(buf, day->prefix, day->prefix_len);
+        size_t len = day->prefix_len;
+        if(!recent){
+            memcpy(buf + len, day->year, day->year_len);
+            return len + day->year_len;
+        }
+        long minutes = (sec - day->start) / 60;
+        buf[len++] = (char)('0' + minutes / 600);
+        buf[len++] = (char)('0' + minutes / 60 % 10);
+        buf[len++] = ':';
+        buf[len++] = (char)('0' + minutes % 60 / 10);
+        buf[len++] = (char)('0' + minutes % 10);
+        return len;
+    }
+
+    time_t t = (time_t)sec;
+    struct tm tm;
+    if(!localtime_r(&t, &tm))
+        return (size_t)snprintf(buf, 64, "%ld", sec);
+    return strftime(buf, 64, recent ? "%b %e %H:%M" : "%b %e  %Y", &tm);
+}
+
+/*
+ * out_epoch_ns
+ * ------------
+ * Write a timestamp as "seconds.nanoseconds" (--time-style=epoch-ns),
+ * straight from the stored fields.
+ *
+ * Notes:
+ *   - Before 1970, sec is rounded down and nsec counts up from it, so a
+ *     nonzero nsec borrows one second: (-2, 500000000) is -1.500000000
+ */
+static void out_epoch_ns(long sec, long nsec){
+    if(sec < 0){
+        if(nsec > 0){
+            sec++;
+            nsec = 1000000000 - nsec;
+        }
+        out_char('-');
+        out_uint((uint64_t)-(sec + 1) + 1, 0);
+    }
+    else
+        out_uint((uint64_t)sec, 0);
+    out_char('.');
+    char digits[9];
+    for(int i = 8; i >= 0; --i){
+        digits[i] = (char)('0' + nsec % 10);
+        nsec /= 10;
+    }
+    out_write(digits, sizeof(digits));
+}
+
+/*
+ * long_widths_t
+ * -------------
+ * Column widths of one long listing.
+ */
+typedef struct{
+    int nlink;
+    int owner;
+    int group;
+    int size;   // includes "major, minor" of device files
+    int minor;
+}long_widths_t;
+
+static bool is_device(uint32_t mode){
+    return S_ISCHR(mode) || S_ISBLK(mode);
+}
+
+/*
+ * print_long
+ * ----------
+ * Print rows in the long format.
+ *
+ * Parameters:
+ *   rows     - entries in display order
+ *   count    - number of rows to print
+ *   measured - number of rows the column widths are computed over
+ *              (at least count)
+ *   dfd      - directory the names are relative to, for readlinkat()
+ *   arena    - names are arena-stored (length-prefixed) rather than paths
+ *   opts     - parsed options; --time-style selects the time column
+ */
+static void print_long(const file_info_t* const* rows, int count, int measured, int dfd, bool arena,
+                       const options_t* opts){
+    long_widths_t w = {0, 0, 0, 0, 0};
+    int major_w = 0;
+    for(int i = 0; i < measured; ++i){
+        const file_info_t* f = rows[i];
+        int d = uint_digits(f->nlink);
+        w.nlink = d > w.nlink ? d : w.nlink;
+        int len = (int)id_name(&users, f->uid)->len;
+        w.owner = len > w.owner ? len : w.owner;
+        len = (int)id_name(&groups, f->gid)->len;
+        w.group = len > w.group ? len : w.group;
+        if(is_device(f->mode)){
+            d = uint_digits(major(f->size));
+            major_w = d > major_w ? d : major_w;
+            d = uint_digits(minor(f->size));
+            w.minor = d > w.minor ? d : w.minor;
+        }
+        else{
+            d = uint_digits(f->size);
+            w.size = d > w.size ? d : w.size;
+        }
+    }
+    if(major_w && major_w + 2 + w.minor > w.size)
+        w.size = major_w + 2 + w.minor;
+
+    for(int i = 0; i < count; ++i){
+        const file_info_t* f = rows[i];
+        char buf[PATH_MAX];
+
+        format_mode(f->mode, buf);
+        buf[10] = ' ';
+        out_write(buf, 11);
+        out_uint(f->nlink, w.nlink);
+        out_char(' ');
+
+        const id_slot_t* id = id_name(&users, f->uid);
+        out_write(id->name, id->len);
+        out_spaces((size_t)(w.owner - (int)id->len) + 1);
+        id = id_name(&groups, f->gid);
+        out_write(id->name, id->len);
+        out_spaces((size_t)(w.group - (int)id->len) + 1);
+
+        if(is_device(f->mode)){
+            out_uint(major(f->size), w.size - w.minor - 2);
+            out_write(", ", 2);
+            out_uint(minor(f->size), w.minor);
+        }
+        else
+            out_uint(f->size, w.size);
+        out_char(' ');
+
+        if(opts->time_epoch_ns)
+            out_epoch_ns(f->sec, f->nsec);
+        else
+            out_write(buf, format_time(f->sec, f->nsec, buf));
+        out_char(' ');
+
+        out_write(f->name, arena ? entry_name_len(f->name) : strlen(f->name));
+        if(S_ISLNK(f->mode)){
+            uint64_t start = stats_call_begin();
+            ssize_t n = readlinkat(dfd, f->name, buf, sizeof(buf));
+            stats_call_end(STATS_SYS_READLINK, start, f->name);
+            if(n >= 0){
+                out_write(" -> ", 4);
+                out_write(buf, (size_t)n);
+            }
+        }
+        out_char('\n');
+    }
+}
+
+/*
+ * fit_columns
+ * -----------
+ * Measure a layout with cols columns the way GNU ls does.
+ *
+ * Parameters:
+ *   widths     - display width of every name, in display order
+ *   n          - number of names
+ *   cols       - candidate number of columns
+ *   across     - fill rows first (-x) instead of columns first (-C)
+ *   line_width - available width
+ *   col_width  - output: width of each column, including the two-space
+ *                gap except for the last column, at least MIN_COLUMN_WIDTH
+ *
+ * Returns:
+ *   true if the line stays shorter than line_width. Stops measuring as
+ *   soon as it does not.
+ */
+static bool fit_columns(const uint16_t* widths, int n, int cols, bool across,
+                        int line_width, size_t* col_width){
+    int rows = (n + cols - 1) / cols;
+    size_t line = (size_t)cols * MIN_COLUMN_WIDTH;
+    for(int j = 0; j < cols; ++j)
+        col_width[j] = MIN_COLUMN_WIDTH;
+
+    for(int i = 0, col = 0, left = rows; i < n; ++i){
+        size_t real = widths[i] + (col == cols - 1 ? 0 : 2);
+        if(col_width[col] < real){
+            line += real - col_width[col];
+            col_width[col] = real;
+            if(line >= (size_t)line_width)
+                return false;
+        }
+        // advance to the column of entry i + 1
+        if(across)
+            col = col + 1 == cols ? 0 : col + 1;
+        else if(--left == 0){
+            col++;
+            left = rows;
+        }
+    }
+    return true;
+}
+
+/*
+ * choose_columns
+ * --------------
+ * Find the largest number of columns whose layout fits the line.
+ *
+ * Returns:
+ *   The number of columns (1 if nothing wider fits); col_width holds
+ *   their widths.
+ *
+ * Behavior:
+ *   - Tries candidates from the most columns down, keeping the first
+ *     that fits, which is the layout GNU ls picks
+ *   - Skips a candidate in O(1) when even the average name width per
+ *     column cannot fit: a column is at least as wide as the mean of its
+ *     at most rows entries, so the line needs at least
+ *     ceil(total / rows) + 2 * (used columns - 1)
+ */
+static int choose_columns(const uint16_t* widths, int n, bool across, int line_width,
+                          size_t* col_width){
+    uint64_t total = 0;
+    for(int i = 0; i < n; ++i)
+        total += widths[i];
+
+    int max_cols = line_width / MIN_COLUMN_WIDTH;
+    if(max_cols < 1)
+        max_cols = 1;
+    if(max_cols > n)
+        max_cols = n;
+
+    for(int cols = max_cols; cols > 1; --cols){
+        uint64_t rows = (uint64_t)(n + cols - 1) / cols;
+        uint64_t used = ((uint64_t)n + rows - 1) / rows;
+        if((total + rows - 1) / rows + 2 * (used - 1) >= (uint64_t)line_width)
+            continue;
+        if(fit_columns(widths, n, cols, across, line_width, col_width))
+            return cols;
+    }
+    col_width[0] = 0;
+    return 1;
+}
+
+/*
+ * indent
+ * ------
+ * Pad from column from to column to, with tabs where a whole tab stop
+ * fits and spaces otherwise (as GNU ls does with its default tab size).
+ */
+static void indent(size_t from, size_t to){
+    while(from < to){
+        if(to / TAB_SIZE > (from + 1) / TAB_SIZE){
+            out_char('\t');
+            from += TAB_SIZE - from % TAB_SIZE;
+        }
+        else{
+            out_char(' ');
+            from++;
+        }
+    }
+}
+
+static void put_name(const file_info_t* f, bool arena){
+    out_write(f->name, arena ? entry_name_len(f->name) : strlen(f->name));
+}
+
+/*
+ * print_columns
+ * -------------
+ * Print names in columns (-C) or rows (-x) fitted to opts->line_width.
+ *
+ * Parameters:
+ *   rows  - entries in display order
+ *   n     - number of entries
+ *   arena - names are arena-stored (length-prefixed) rather than paths
+ *   opts  - parsed options
+ */
+static void print_columns(const file_info_t* const* rows, int n, bool arena, const options_t* opts){
+    if(n == 0)
+        return;
+    bool across = opts->columns == 'x';
+    uint16_t* widths = xmalloc((size_t)n * sizeof(uint16_t));
+    for(int i = 0; i < n; ++i)
+        widths[i] = rows[i]->width;
+    int max_cols = opts->line_width / MIN_COLUMN_WIDTH;
+    size_t* col_width = xmalloc((size_t)(max_cols > 1 ? max_cols : 1) * sizeof(size_t));
+    int cols = choose_columns(widths, n, across, opts->line_width, col_width);
+
+    if(across){
+        size_t pos = 0;
+        put_name(rows[0], arena);
+        for(int i = 1; i < n; ++i){
+            int col = i % cols;
+            if(col == 0){
+                out_char('\n');
+                pos = 0;
+            }
+            else{
+                indent(pos + widths[i - 1], pos + col_width[col - 1]);
+                pos += col_width[col - 1];
+            }
+            put_name(rows[i], arena);
+        }
+        out_char('\n');
+    }
+    else{
+        int nrows = (n + cols - 1) / cols;
+        for(int row = 0; row < nrows; ++row){
+            size_t pos = 0;
+            for(int i = row, col = 0; ; ++col){
+                put_name(rows[i], arena);
+                int next = i + nrows;
+                if(next >= n)
+                    break;
+                indent(pos + widths[i], pos + col_width[col]);
+                pos += col_width[col];
+                i = next;
+            }
+            out_char('\n');
+        }
+    }
+    free(col_width);
+    free(widths);
+}
+
+/*
+ * print_listing
+ * -------------
+ * Format the entries of one directory (see print_entries()).
+ */
+static void print_listing(const file_list_t* flist, const char* dir, const options_t* opts){
+    if(!opts->long_format && !opts->columns){
+        for(int i = 0; i < flist->count; ++i){
+            const char* name = file_list_at(flist, i)->name;
+            out_line(name, entry_name_len(name));
+        }
+        return;
+    }
+
+    const file_info_t** rows = xmalloc((size_t)(flist->count ? flist->count : 1) * sizeof(*rows));
+    uint64_t blocks = 0;
+    bool links = false;
+    for(int i = 0; i < flist->count; ++i){
+        rows[i] = file_list_at(flist, i);
+        blocks += rows[i]->blocks;
+        links |= S_ISLNK(rows[i]->mode);
+    }
+    if(opts->columns){
+        print_columns(rows, flist->count, true, opts);
+        free(rows);
+        return;
+    }
+    out_write("total ", 6);
+    out_uint((blocks + 1) / 2, 0);
+    out_char('\n');
+
+    // link targets are read relative to the directory, opened only if needed
+    int dfd = -1;
+    if(links){
+        uint64_t start = stats_call_begin();
+        dfd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        stats_call_end(STATS_SYS_OPEN, start, NULL);
+    }
+    print_long(rows, flist->count, flist->count, dfd, true, opts);
+    if(dfd >= 0)
+        close(dfd);
+    free(rows);
+}
+
+/*
+ * print_entries
+ * -------------
+ * Print the entries of one directory in display order.
+ *
+ * Parameters:
+ *   flist - entries read by read_directory(), possibly sorted
+ *   dir   - path of the directory, used to resolve symbolic link targets
+ *   opts  - parsed options; -l selects the long format, -C / -x columns
+ *
+ * Behavior:
+ *   - By default, prints one name per line
+ *   - With -C / -x, prints the names in columns fitted to the terminal
+ *   - With -l, prints "total N" (allocated space in 1 KiB blocks, rounded
+ *     up) followed by one long-format row per entry
+ *   - Times the output phase and closes the directory's --stats record
+ */
+void print_entries(const file_list_t* flist, const char* dir, const options_t* opts){
+    stats_span_t span;
+    stats_begin(&span);
+    stats_set_dir(dir);
+    print_listing(flist, dir, opts);
+    stats_set_dir(NULL);
+    stats_end(&span, STATS_OUTPUT, (uint64_t)flist->count, flist->stats);
+    if(flist->stats)
+        stats_dir_close(flist->stats, file_list_bytes(flist));
+}
+
+/*
+ * print_operands
+ * --------------
+ * Print non-directory operands, by path, in the given order.
+ *
+ * Parameters:
+ *   ops       - operands classified by gather_paths()
+ *   count     - number of operands
+ *   dirs      - directory operands, only measured for -l column widths
+ *   dir_count - number of directory operands
+ *   opts      - parsed options; -l selects the long format, -C / -x columns
+ *
+ * Notes:
+ *   - The long format reuses the metadata captured during classification
+ *     and prints no "total" line
+ *   - Like GNU ls, -l column widths also cover the directory operands
+ */
+void print_operands(const operand_t* ops, int count, const operand_t* dirs, int dir_count,
+                    const options_t* opts){
+    if(count == 0)
+        return;
+    stats_span_t span;
+    stats_begin(&span);
+    if(!opts->long_format && !opts->columns){
+        for(int i = 0; i < count; ++i)
+            out_line(ops[i].path, strlen(ops[i].path));
+        stats_end(&span, STATS_OUTPUT, (uint64_t)count, NULL);
+        return;
+    }
+
+    const file_info_t** rows = xmalloc((size_t)(count + dir_count) * sizeof(*rows));
+    for(int i = 0; i < count; ++i)
+        rows[i] = &ops[i].info;
+    for(int i = 0; i < dir_count; ++i)
+        rows[count + i] = &dirs[i].info;
+    if(opts->columns)
+        print_columns(rows, count, false, opts);
+    else
+        print_long(rows, count, count + dir_count, AT_FDCWD, false, opts);
+    free(rows);
+    stats_end(&span, STATS_OUTPUT, (uint64_t)count, NULL);
+}
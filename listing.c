@@ -0,0 +1,225 @@
+/*
+ * Directory Listing
+ * -----------------
+ * Reading one directory into a file_list_t (read_directory()) or straight
+ * to the output (stream_directory()), and the selection of the metadata
+ * the active options need.
+ *
+ * Shared by main(), the read-ahead pipeline and the recursive traversal;
+ * the stat engines it drives live in statpool.c and uring.c, the top-K
+ * reader used for --head / --tail in topk.c.
+ */
+
+#include "myls.h"
+
+/*
+ * stat_fields
+ * -----------
+ * Compute the set of metadata fields the selected options require.
+ *
+ * Parameters:
+ *   opts - parsed command-line options
+ *
+ * Returns:
+ *   A mask of STAT_NEED_* bits. STAT_NEED_TYPE is always included since
+ *   every entry records is_dir.
+ *
+ * Notes:
+ *   - New metadata-dependent options must add their fields here so that
+ *     the fast path in read_directory() is disabled for them
+ */
+unsigned stat_fields(const options_t* opts){
+    unsigned fields = STAT_NEED_TYPE;
+    if(opts->sort_time)
+        fields |= STAT_NEED_MTIME;
+    if(opts->long_format)
+        fields |= STAT_NEED_MTIME | STAT_NEED_MODE | STAT_NEED_NLINK |
+                  STAT_NEED_OWNER | STAT_NEED_SIZE;
+    return fields;
+}
+
+/*
+ * needs_metadata
+ * --------------
+ * Report whether the selected options require per-entry stat metadata.
+ *
+ * Parameters:
+ *   opts - parsed command-line options
+ *
+ * Returns:
+ *   true if any requested field goes beyond the file type, which readdir
+ *   already reports through d_type; false if readdir data is sufficient.
+ */
+bool needs_metadata(const options_t* opts){
+    return (stat_fields(opts) & ~STAT_NEED_TYPE) != 0;
+}
+
+/*
+ * read_entries
+ * ------------
+ * Collect every entry of a directory (see read_directory()).
+ */
+static file_list_t read_entries(const char* path, const options_t* opts){
+    file_list_t flist;
+    file_list_init(&flist);
+    bool want_stat = needs_metadata(opts);
+    bool batch = want_stat && (opts->jobs > 1 || opts->io_uring);
+    unsigned fields = stat_fields(opts);
+
+    dir_reader_t dir;
+    if(dir_reader_open(&dir, path, 0)){
+        // we can't open dir
+        fprintf(stderr, "myls: cannot access %s\n", path);
+        return flist;
+    }
+
+    dir_entry_t entry;
+    while(dir_reader_next(&dir, &entry) > 0){
+        // check show_all, skip '.'
+        if(!opts->show_all && entry.name[0] == '.')
+            continue;
+
+        // fast path: readdir data is enough
+        if(!want_stat && entry.type != DT_UNKNOWN){
+            file_info_t* info = file_list_add(&flist, entry.name, entry.len);
+            info->is_dir = entry.type == DT_DIR;
+            continue;
+        }
+
+        // --jobs / --io-uring: collect now, stat the whole batch below
+        if(batch){
+            file_list_add(&flist, entry.name, entry.len);
+            continue;
+        }
+
+        // stat relative to the open directory
+        file_info_t meta;
+        if(!stat_entry(dir.fd, entry.name, fields, &meta)){
+            // fill the file_info_t
+            file_info_t* info = file_list_add(&flist, entry.name, entry.len);
+            meta.name = info->name;
+            meta.width = info->width;
+            *info = meta;
+        }
+    }
+    if(batch && (!opts->io_uring || uring_stat_run(dir.fd, &flist, fields)))
+        stat_pool_run(dir.fd, &flist, fields);
+    dir_reader_close(&dir);
+    return flist;
+}
+
+/*
+ * read_directory
+ * --------------
+ * Read the contents of a directory and collect metadata for each entry.
+ *
+ * Parameters:
+ *   path - filesystem path to the directory to be read
+ *   opts - parsed options; -a controls hidden entries and
+ *          needs_metadata() decides whether entries are stat'ed
+ *
+ * Returns:
+ *   A file_list_t structure containing metadata for each directory entry.
+ *   If the directory cannot be opened, an empty file_list_t is returned.
+ *
+ * Behavior:
+ *   - Opens the directory specified by path with dir_reader_open()
+ *   - Iterates over directory entries in large getdents64 batches using
+ *     dir_reader_next(); names are copied once, into the list's arena
+ *   - Skips hidden entries (names starting with '.') unless -a is set
+ *   - When metadata is needed, retrieves it with stat_entry() relative to
+ *     the directory's file descriptor, asking only for stat_fields();
+ *     entries that cannot be stat'ed are skipped
+ *   - With --jobs N or --io-uring, all names are collected first and
+ *     stat'ed as one batch by uring_stat_run() or the worker pool in
+ *     stat_pool_run(); both yield the same entries in the same order as
+ *     the serial loop, and the pool (which is serial without --jobs)
+ *     takes over whenever io_uring is unavailable
+ *   - Otherwise takes is_dir from d_type and never calls lstat(), except
+ *     for entries whose d_type is DT_UNKNOWN
+ *   - Records the following information per entry:
+ *       • entry name
+ *       • modification time (seconds and nanoseconds; zero on the fast path)
+ *       • whether the entry is a directory
+ *   - Appends entries to a growable file_list_t; names are copied into
+ *     the list's string arena, so no directory is truncated
+ *   - Closes the directory stream before returning
+ *   - With --head / --tail, hands over to read_directory_topk(), which
+ *     keeps only the selected entries while reading
+ *   - With --stats, opens the directory's record (flist.stats) and times
+ *     the read phase
+ *
+ * Notes:
+ *   - Entries are returned in filesystem order; no sorting is performed
+ *   - Symbolic links are not followed (AT_SYMLINK_NOFOLLOW)
+ *   - No full paths are built, so nesting depth is not limited by PATH_MAX
+ *   - The caller owns the returned list and must release it with
+ *     file_list_free()
+ */
+file_list_t read_directory(const char* path, const options_t* opts){
+    dir_stats_t* record = stats_dir_open(path);
+    stats_span_t span;
+    stats_begin(&span);
+    stats_set_dir(path);
+    file_list_t flist = opts->limit > 0 ? read_directory_topk(path, opts)
+                                        : read_entries(path, opts);
+    stats_set_dir(NULL);
+    flist.stats = record;
+    stats_end(&span, STATS_READ, (uint64_t)flist.count, record);
+    return flist;
+}
+
+/*
+ * stream_directory
+ * ----------------
+ * Print the entries of a directory in filesystem order as they are read
+ * (-U / -f).
+ *
+ * Parameters:
+ *   path - filesystem path to the directory to be listed
+ *   opts - parsed options; -a controls hidden entries
+ *
+ * Returns:
+ *   0 on success, -1 if the directory could not be opened or read.
+ *
+ * Behavior:
+ *   - Each entry goes from the getdents64 buffer straight into the output
+ *     buffer; nothing is collected, sorted or stat'ed
+ *   - Memory use is constant regardless of directory size, and output
+ *     starts as soon as the first batch has been read
+ *   - With --head N, stops reading after N entries
+ *   - With --stats, the whole listing is timed as the directory's read
+ *     phase, since reading and output are interleaved
+ */
+int stream_directory(const char* path, const options_t* opts){
+    dir_stats_t* record = stats_dir_open(path);
+    stats_span_t span;
+    stats_begin(&span);
+    stats_set_dir(path);
+    dir_reader_t dir;
+    if(dir_reader_open(&dir, path, 0)){
+        fprintf(stderr, "myls: cannot access %s\n", path);
+        stats_set_dir(NULL);
+        stats_end(&span, STATS_READ, 0, record);
+        stats_dir_close(record, 0);
+        return -1;
+    }
+
+    dir_entry_t entry;
+    int ret;
+    int left = opts->limit;
+    uint64_t listed = 0;
+    while((ret = dir_reader_next(&dir, &entry)) > 0){
+        if(!opts->show_all && entry.name[0] == '.')
+            continue;
+        out_line(entry.name, entry.len);
+        listed++;
+        if(left > 0 && --left == 0)
+            break;
+    }
+    dir_reader_close(&dir);
+    stats_set_dir(NULL);
+    stats_end(&span, STATS_READ, listed, record);
+    stats_dir_close(record, 0);
+    return ret < 0 ? -1 : 0;
+}
@@ -7,6 +7,22 @@
  *   1. Parse command-line options:
  *        - `-a` to include hidden files
  *        - `-t` to sort by modification time
+ *        - `-R` to list subdirectories recursively
+ *        - `-l` to use the long listing format
+ *        - `-C` / `-x` to list names in columns (down / across),
+ *          `-1` for one name per line; `-C` is the default on a terminal
+ *        - `-U` / `-f` to stream entries unsorted (`-f` also implies `-a`)
+ *        - `--jobs N` to stat entries (or, with -R, read directories)
+ *          with N parallel workers
+ *        - `--io-uring` to stat entries with batched io_uring statx
+ *          (ignored by -R --jobs N, whose workers stat serially)
+ *        - `--head N` / `--tail N` to list only the first / last N
+ *          entries of each directory
+ *        - `--time-style=epoch-ns` to print -l times as raw seconds and
+ *          nanoseconds
+ *        - `--stats[=json]` to report phase timings and counters on stderr,
+ *          `--stats-slowest=N` to also name the N slowest system calls
+ *        - `--trace=FILE` to write a Chrome Trace Event timeline to FILE
  *
  *   2. Process operands:
  *        - Separate files and directories
@@ -14,383 +30,426 @@
  *
  *   3. Sort operands:
  *        - Lexicographically by name (default)
- *        - By modification time when `-t` is specified
+ *        - By modification time when `-t` is specified, using the
+ *          metadata captured while classifying them
  *
  *   4. Display output:
  *        - Print files first, followed by directories
  *        - Format output to match standard `ls` behavior
+ *        - All output goes through the buffered writer in output.c
  *
  *   5. Cleanup:
  *        - Release any acquired resources (directory streams, etc.)
  */
 
 #include "myls.h"
+#include<sys/ioctl.h>
 
 int main(int argc, char** argv){
     // parse options
     options_t opts = parse_options(argc,argv);
-    
-    // store directories and paths
-    char* dirs[argc];
-    char* non_dirs[argc];
-    memset(dirs,0,sizeof(dirs));
-    memset(non_dirs,0,sizeof(non_dirs));
-    int dir_count = 0;
-    int non_dir_count = 0;
-    
-    // gather paths
-    gather_paths(argc,argv,non_dirs,&non_dir_count,dirs,&dir_count);
+    if(opts.stats)
+        stats_start(opts.stats, opts.stats_slowest);
+    if(opts.trace && trace_start(opts.trace)){
+        fprintf(stderr, "myls: cannot open trace file %s: %s\n", opts.trace, strerror(errno));
+        return 1;
+    }
+    // -R --jobs N: the traversal workers stat serially, so no ring
+    if(opts.io_uring && opts.recursive && opts.jobs > 1)
+        opts.io_uring = false;
+    if(opts.io_uring && uring_start())
+        opts.io_uring = false; // unavailable: use the synchronous path
+    out_init(STDOUT_FILENO, 0);
+
+    // --jobs N: the stat pool classifies large operand lists in parallel
+    // and later stats the entries of a single directory
+    if(opts.jobs > 1)
+        stat_pool_start(opts.jobs);
+
+    // gather and classify operands into heap lists
+    operand_list_t dirs, non_dirs;
+    operand_list_init(&dirs);
+    operand_list_init(&non_dirs);
+    gather_paths(argc,argv,&opts,&non_dirs,&dirs);
 
-    // sort non-directories lexicographically
-    if(non_dir_count > 1)
-        sort_entries(non_dirs, non_dir_count);
+    // sort operands by name or -t time from the classification metadata
+    // (-U keeps argument order)
+    if(non_dirs.count > 1 && !opts.unsorted)
+        sort_operands(non_dirs.items, non_dirs.count, opts.sort_time);
+    if(dirs.count > 1 && !opts.unsorted)
+        sort_operands(dirs.items, dirs.count, opts.sort_time);
 
-    // sort directories lexicographically
-    if(dir_count > 1)
-        sort_entries(dirs, dir_count);
+    // start the parallel engine that fits the work:
+    //   -R                     -> work-stealing traversal
+    //   several dirs, --jobs N -> read-ahead pipeline
+    //   one dir, --jobs N      -> parallel stat pool (already running)
+    //   -U without -R          -> none, entries are streamed
+    //                             (--tail, -l and -C need the whole directory)
+    bool read_ahead = false;
+    bool stream = opts.unsorted && !opts.recursive && !opts.limit_tail &&
+                  !opts.long_format && !opts.columns;
+    if(opts.recursive)
+        traverse_start(&opts);
+    else if(stream)
+        ;
+    else if(opts.jobs > 1 && dirs.count > 1)
+        read_ahead = !read_ahead_start(dirs.items, dirs.count, &opts);
 
     // print non directories
-    for(int i = 0; i < non_dir_count; ++i){
-        printf("%s\n",non_dirs[i]);
-    }
+    print_operands(non_dirs.items, non_dirs.count, dirs.items, dirs.count, &opts);
 
-    if(non_dir_count > 0 && dir_count > 0)
-        printf("\n");
+    if(non_dirs.count > 0 && dirs.count > 0)
+        out_char('\n');
 
     // for each directory read, sort, print
-    for(int i = 0; i < dir_count; ++i){
-        if(dir_count > 1){
-            printf("%s:\n",dirs[i]);
+    for(int i = 0; i < dirs.count; ++i){
+        const char* path = dirs.items[i].path;
+        if(opts.recursive){
+            // -R: headers on every block, blank line between blocks
+            // (the one after the non-directories is already printed)
+            bool printed = i > 0;
+            list_recursive(path, &printed);
+            continue;
         }
 
-        // read the directory
-        file_list_t flist = read_directory(dirs[i],opts.show_all);
-        sort_file_list(&flist, opts.sort_time);
-        for (int j = 0; j < flist.count; ++j)
-            printf("%s\n", flist.files[j].name);
+        if(dirs.count > 1){
+            out_write(path, strlen(path));
+            out_write(":\n", 2);
+        }
 
-        if (i < dir_count - 1)
-            printf("\n");
-    }
-    return 0;
-}
+        // -U: entries go straight from the reader to the output
+        if(stream){
+            stream_directory(path, &opts);
+            if (i < dirs.count - 1)
+                out_char('\n');
+            continue;
+        }
 
-/*
- * parse_options
- * -------------
- * Parses command-line arguments and extracts flags.
- *   
- * Parameters:
- *   argc,argv - arguments passed to main()
- *
- * Returns:
- *   An options_t structure holding provided flags
- *
- * Behaviour:
- *   - Recognizes -a and -t flag
- *   - Exits with an error or invalid flag options
- */
-options_t parse_options(int argc, char** argv){
-    options_t opts;
-    opts.show_all = false;
-    opts.sort_time =false;
+        // read the directory (or take it from the read-ahead buffer)
+        file_list_t flist;
+        if(read_ahead)
+            flist = read_ahead_take(i);
+        else{
+            flist = read_directory(path,&opts);
+            if(!opts.unsorted)
+                sort_file_list(&flist, opts.sort_time);
+        }
+        print_entries(&flist, path, &opts);
+        file_list_free(&flist);
 
-    // scan all arguments for flags
-    for(int i = 1; i < argc; ++i)
-        if(argv[i][0] == '-')
-            for(int j = 1; argv[i][j] != '\0'; ++j){
-                if(argv[i][j] == 'a')
-                    opts.show_all = true;
-                else if(argv[i][j] == 't')
-                    opts.sort_time = true;
-                else{
-                    printf("myls: invalid option -- %c\n", argv[i][j]);
-                    exit(1);
-                }    
-            }
-    return opts;
+        if (i < dirs.count - 1)
+            out_char('\n');
+    }
+    if(read_ahead)
+        read_ahead_stop();
+    traverse_stop();
+    stat_pool_stop();
+    uring_stop();
+    operand_list_free(&dirs);
+    operand_list_free(&non_dirs);
+
+    stats_span_t span;
+    stats_begin(&span);
+    int status = out_flush() ? 1 : 0;
+    stats_end(&span, STATS_OUTPUT, 0, NULL);
+    trace_finish();
+    stats_report();
+    return status;
 }
 
 /*
- * gather_paths
+ * long_options
  * ------------
- * Process command-line operands and classify them into directories
- * and non-directory files.
- *
- * Parameters:
- *   argc, argv        - arguments passed to main()
- *   non_dirs          - output array for non-directory paths (files)
- *   non_dir_count     - output count of non-directory paths
- *   dirs              - output array for directory paths
- *   dir_count         - output count of directory paths
- *
- * Returns:
- *   The total number of valid non-option operands processed.
- *
- * Behavior:
- *   - Skips argv[0] (program name) and all option arguments (prefixed with '-')
- *   - Attempts to open each operand as a directory using opendir()
- *   - If opendir() succeeds, the operand is treated as a directory
- *   - Otherwise, uses lstat() to check if the operand refers to a valid file
- *   - Valid files are classified as non-directory paths
- *   - Invalid operands result in an error message and are ignored
- *   - If no valid non-option operands are provided, defaults to the current
- *     directory (".")
+ * Table of recognised long options. A REQUIRED_ARG value is given either
+ * as "--name=VALUE" or as the following argument; an OPTIONAL_ARG value
+ * only as "--name=VALUE".
  */
-int gather_paths(int argc,char** argv,char** non_dirs,int* non_dir_count,char** dirs,int* dir_count){
-    int total = 0;
-    *dir_count = 0;
-    *non_dir_count = 0;
+#define NO_ARG       0
+#define REQUIRED_ARG 1
+#define OPTIONAL_ARG 2
 
-    // skip argv[0] --> ./myls
-    for(int i = 1; i < argc; ++i){
-        if(argv[i][0] == '-')
-            continue;
-        
-        // try opening as a directory
-        DIR *temp_dir = opendir(argv[i]);
-        if(temp_dir){
-            // valid directory
-            closedir(temp_dir);
-            dirs[*dir_count] = argv[i];
-            (*dir_count)++;
-            total++;
-        }
-        else{
-            // not a directory --> file / invalid
-            struct stat st; // stat --> display file or file system status
-            if(!lstat(argv[i],&st)){
-                // existing file
-                non_dirs[*non_dir_count] = argv[i];
-                (*non_dir_count)++;
-                total++;
-            }
-            else{
-                // invalid
-                printf("myls: cannot access -- %s\n",argv[i]);
-            }
-        }
-    }
-    // no valid non-options args provided, default
-    if(total == 0){
-        dirs[0] = ".";
-        *dir_count = 1;
-        total = 1;
-    }
-    return total;
-}
+static const struct{
+    const char* name;
+    int has_arg;
+}long_options[] = {
+    {"jobs", REQUIRED_ARG},
+    {"io-uring", NO_ARG},
+    {"head", REQUIRED_ARG},
+    {"tail", REQUIRED_ARG},
+    {"time-style", REQUIRED_ARG},
+    {"stats", OPTIONAL_ARG},
+    {"stats-slowest", REQUIRED_ARG},
+    {"trace", REQUIRED_ARG},
+};
+
+#define LONG_OPTION_COUNT (int)(sizeof(long_options) / sizeof(long_options[0]))
 
 /*
- * cmp_lex
- * -------
- * Comparator function for lexicographical (alphabetical) ordering of strings.
+ * find_long_option
+ * ----------------
+ * Look up a long option by name.
  *
  * Parameters:
- *   a, b - pointers to elements being compared by qsort()
+ *   arg   - argument with the leading "--" already stripped
+ *   value - output: text after '=' if present, NULL otherwise
  *
  * Returns:
- *   < 0 if the string pointed to by a comes before b
- *   > 0 if the string pointed to by a comes after b
- *   = 0 if both strings are equal
- *
- * Behavior:
- *   - Interprets input pointers as pointers to C strings (char *)
- *   - Compares strings using strcmp()
+ *   Index into long_options, or -1 if the option is not recognised.
  */
-static int cmp_lex(const void *a, const void *b) {
-    const char *s1 = *(const char **)a;
-    const char *s2 = *(const char **)b;
-    return strcmp(s1, s2);
+static int find_long_option(const char* arg, const char** value){
+    const char* eq = strchr(arg, '=');
+    size_t len = eq ? (size_t)(eq - arg) : strlen(arg);
+    *value = eq ? eq + 1 : NULL;
+
+    for(int i = 0; i < LONG_OPTION_COUNT; ++i)
+        if(strlen(long_options[i].name) == len && !strncmp(long_options[i].name, arg, len))
+            return i;
+    return -1;
 }
 
 /*
- * sort_entries
- * ------------
- * Sort an array of directory entry names in lexicographical order.
+ * option_value_count
+ * ------------------
+ * Report how many of the following arguments an option argument consumes.
  *
  * Parameters:
- *   entries - array of C strings representing entry names
- *   count   - number of entries in the array
+ *   arg - a command-line argument beginning with '-'
  *
- * Behavior:
- *   - Sorts entries in-place using qsort()
- *   - Ordering is based on strcmp() comparison
+ * Returns:
+ *   1 for a long option with a required value written without '='
+ *   (e.g. "--jobs 8"),
+ *   0 otherwise. Used by gather_paths() so option values are not mistaken
+ *   for operands.
  */
-void sort_entries(char **entries, int count) {
-    qsort(entries, count, sizeof(char *), cmp_lex);
+int option_value_count(const char* arg){
+    if(arg[0] != '-' || arg[1] != '-')
+        return 0;
+    const char* value;
+    int idx = find_long_option(arg + 2, &value);
+    return idx >= 0 && long_options[idx].has_arg == REQUIRED_ARG && !value;
 }
 
 /*
- * read_directory
+ * parse_positive
  * --------------
- * Read the contents of a directory and collect metadata for each entry.
- *
- * Parameters:
- *   path        - filesystem path to the directory to be read
- *   show_hidden - when true, include entries whose names begin with '.'
- *
- * Returns:
- *   A file_list_t structure containing metadata for each directory entry.
- *   If the directory cannot be opened, an empty file_list_t is returned.
- *
- * Behavior:
- *   - Opens the directory specified by path using opendir()
- *   - Iterates over directory entries using readdir()
- *   - Skips hidden entries (names starting with '.') unless show_hidden is true
- *   - Constructs a full path for each entry and retrieves metadata via lstat()
- *   - Records the following information per entry:
- *       • entry name
- *       • modification time (seconds and nanoseconds)
- *       • whether the entry is a directory
- *   - Stores entries in a fixed-size file_list_t container, up to MAX_FILES
- *   - Prints a warning if the number of entries exceeds MAX_FILES
- *   - Closes the directory stream before returning
- *
- * Notes:
- *   - Entries are returned in filesystem order; no sorting is performed
- *   - Symbolic links are not followed (lstat is used)
- *   - Memory ownership remains local; no dynamic allocation is performed
+ * Parse the value of a numeric long option, exiting on invalid input.
  */
-file_list_t read_directory(const char* path, bool show_hidden){
-    file_list_t flist;
-    flist.count = 0;
-
-    DIR* dir = opendir(path);
-    if(!dir){
-        // we can't open dir
-        fprintf(stderr, "myls: cannot access %s\n", path);
-        return flist;
-    }
-
-    struct dirent *entry;
-    while((entry = readdir(dir)) != NULL){
-        // check show_hidden, skip '.'
-        if(!show_hidden && entry->d_name[0] == '.')
-            continue;
-
-        // build full path for lstat
-        char full_path[PATH_MAX];
-        snprintf(full_path,PATH_MAX,"%s/%s",path,entry->d_name);
-
-        struct stat st;
-        if(!lstat(full_path,&st)){
-            // fill the file_info_t
-            file_info_t info;
-            strncpy(info.name,entry->d_name,PATH_MAX - 1);
-            info.name[PATH_MAX - 1] = '\0';
-
-            info.sec = st.st_mtimespec.tv_sec;
-            info.nsec = st.st_mtimespec.tv_nsec;
-            info.is_dir = S_ISDIR(st.st_mode);
-
-            // add to flist
-            if(flist.count < MAX_FILES){
-                flist.files[flist.count] = info;
-                flist.count++;
-            }
-            else{
-                // MAX_FILES exceeded
-                printf("Warning: too many files in '%s' (max %d). Some entries skipped\n",path,MAX_FILES);
-            }
-        }
+static long parse_positive(const char* option, const char* value){
+    char* end;
+    errno = 0;
+    long n = strtol(value, &end, 10);
+    if(errno || end == value || *end != '\0' || n <= 0){
+        printf("myls: invalid argument '%s' for '--%s'\n", value, option);
+        exit(1);
     }
-    closedir(dir);
-    return flist;
+    return n;
 }
 
 /*
- * sort_file_list
+ * terminal_width
  * --------------
- * Sort the contents of a file_list_t according to the selected ordering mode.
- *
- * Parameters:
- *   flist     - pointer to a file_list_t containing directory entries
- *   sort_time - when true, sort entries by modification time (-t);
- *               otherwise, sort entries lexicographically by name
- *
- * Behavior:
- *   - Sorts the entries in-place using qsort()
- *   - When sort_time is enabled:
- *       • Orders entries by modification time (newest first)
- *       • Uses nanosecond precision to break ties
- *       • Falls back to lexicographical name comparison for stability
- *   - When sort_time is disabled:
- *       • Orders entries alphabetically by name
- *
- * Notes:
- *   - Sorting operates only on the valid portion of the array
- *     as indicated by flist->count
- *   - No memory allocation or copying is performed
+ * Width available to -C / -x: $COLUMNS if set, overridden by the size of
+ * the terminal on standard output (TIOCGWINSZ), 80 if neither is known.
  */
-void sort_file_list(file_list_t *flist, bool sort_time)
-{
-    if (sort_time)
-        qsort(flist->files, flist->count, sizeof(file_info_t), cmp_file_time);
-    else
-        qsort(flist->files, flist->count, sizeof(file_info_t), cmp_file_lex);
+static int terminal_width(void){
+    int width = 80;
+    const char* env = getenv("COLUMNS");
+    if(env && *env){
+        char* end;
+        long n = strtol(env, &end, 10);
+        if(*end == '\0' && n > 0 && n <= INT_MAX)
+            width = (int)n;
+    }
+    struct winsize ws;
+    if(!ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) && ws.ws_col > 0)
+        width = ws.ws_col;
+    return width;
 }
 
 /*
- * cmp_file_time
+ * parse_options
  * -------------
- * Comparator function for time-based ordering of filesystem entries.
- *
+ * Parses command-line arguments and extracts flags.
+ *   
  * Parameters:
- *   a, b - pointers to file_info_t elements being compared
+ *   argc,argv - arguments passed to main()
  *
  * Returns:
- *   < 0 if entry b should appear before entry a
- *   > 0 if entry a should appear before entry b
- *   = 0 if both entries are considered equal
- *
- * Ordering Rules:
- *   - Entries are ordered by modification time in descending order
- *     (most recently modified first)
- *   - Seconds are compared before nanoseconds
- *   - If modification times are identical, entries are ordered
- *     lexicographically by name to ensure stable output
+ *   An options_t structure holding provided flags
  *
- * Notes:
- *   - Intended for use with qsort()
- *   - Declared static as it is internal to this translation unit
+ * Behaviour:
+ *   - Recognizes -a, -t, -R, -U, -f, -l, -C, -x and -1 flags; the last
+ *     of -l / -C / -x / -1 selects the format, and without any of them
+ *     -C is used when standard output is a terminal
+ *   - Recognizes the long options listed in long_options
+ *   - Exits with an error or invalid flag options
  */
-static int cmp_file_time(const void *a, const void *b)
-{
-    const file_info_t *fa = a;
-    const file_info_t *fb = b;
+options_t parse_options(int argc, char** argv){
+    options_t opts;
+    opts.show_all = false;
+    opts.sort_time =false;
+    opts.recursive = false;
+    opts.unsorted = false;
+    opts.jobs = 1;
+    opts.io_uring = false;
+    opts.limit = 0;
+    opts.limit_tail = false;
+    opts.long_format = false;
+    opts.time_epoch_ns = false;
+    opts.columns = 0;
+    opts.line_width = 0;
+    opts.stats = 0;
+    opts.stats_slowest = 0;
+    opts.trace = NULL;
+    bool format_given = false;
 
-    if (fa->sec < fb->sec) return 1;
-    if (fa->sec > fb->sec) return -1;
+    // scan all arguments for flags
+    for(int i = 1; i < argc; ++i){
+        if(argv[i][0] != '-')
+            continue;
 
-    if (fa->nsec < fb->nsec) return 1;
-    if (fa->nsec > fb->nsec) return -1;
+        // long options: --name, --name=VALUE, --name VALUE
+        if(argv[i][1] == '-'){
+            const char* value;
+            int idx = find_long_option(argv[i] + 2, &value);
+            if(idx < 0){
+                printf("myls: unrecognized option '%s'\n", argv[i]);
+                exit(1);
+            }
+            if(long_options[idx].has_arg == REQUIRED_ARG && !value){
+                if(i + 1 >= argc){
+                    printf("myls: option '--%s' requires an argument\n", long_options[idx].name);
+                    exit(1);
+                }
+                value = argv[++i];
+            }
 
-    return strcmp(fa->name, fb->name); // tie-breaker
-}
+            const char* name = long_options[idx].name;
+            if(long_options[idx].has_arg == NO_ARG && value){
+                printf("myls: option '--%s' doesn't allow an argument\n", name);
+                exit(1);
+            }
+            if(!strcmp(name, "jobs"))
+                opts.jobs = (int)parse_positive(name, value);
+            else if(!strcmp(name, "io-uring"))
+                opts.io_uring = true;
+            else if(!strcmp(name, "stats")){
+                // --stats prints text, --stats=json one JSON object
+                if(value && strcmp(value, "json") && strcmp(value, "text")){
+                    printf("myls: invalid argument '%s' for '--%s'\n", value, name);
+                    exit(1);
+                }
+                opts.stats = (value && !strcmp(value, "json")) ? 'j' : 't';
+            }
+            else if(!strcmp(name, "stats-slowest")){
+                long n = parse_positive(name, value);
+                opts.stats_slowest = n > INT_MAX ? INT_MAX : (int)n;
+                if(!opts.stats)
+                    opts.stats = 't';
+            }
+            else if(!strcmp(name, "trace"))
+                opts.trace = value;
+            else if(!strcmp(name, "time-style")){
+                // "locale" is the default GNU-style column
+                if(strcmp(value, "epoch-ns") && strcmp(value, "locale")){
+                    printf("myls: invalid argument '%s' for '--%s'\n", value, name);
+                    exit(1);
+                }
+                opts.time_epoch_ns = !strcmp(value, "epoch-ns");
+            }
+            else{
+                // --head / --tail: the later one wins
+                long n = parse_positive(name, value);
+                opts.limit = n > INT_MAX ? INT_MAX : (int)n;
+                opts.limit_tail = !strcmp(name, "tail");
+            }
+            continue;
+        }
 
+        for(int j = 1; argv[i][j] != '\0'; ++j){
+            if(argv[i][j] == 'a')
+                opts.show_all = true;
+            else if(argv[i][j] == 't'){
+                opts.sort_time = true;
+                opts.unsorted = false;
+            }
+            else if(argv[i][j] == 'U' || argv[i][j] == 'f'){
+                // the later of -t / -U wins; -f also implies -a
+                opts.unsorted = true;
+                opts.sort_time = false;
+                if(argv[i][j] == 'f')
+                    opts.show_all = true;
+            }
+            else if(argv[i][j] == 'R')
+                opts.recursive = true;
+            else if(argv[i][j] == 'l' || argv[i][j] == 'C' ||
+                    argv[i][j] == 'x' || argv[i][j] == '1'){
+                // output format: the last one wins
+                opts.long_format = argv[i][j] == 'l';
+                opts.columns = (argv[i][j] == 'C' || argv[i][j] == 'x') ? argv[i][j] : 0;
+                format_given = true;
+            }
+            else{
+                printf("myls: invalid option -- %c\n", argv[i][j]);
+                exit(1);
+            }    
+        }
+    }
+    if(!format_given && isatty(STDOUT_FILENO))
+        opts.columns = 'C';
+    if(opts.columns)
+        opts.line_width = terminal_width();
+    return opts;
+}
 
 /*
- * cmp_file_lex
+ * gather_paths
  * ------------
- * Comparator function for lexicographical (alphabetical) ordering of
- * filesystem entries by name.
+ * Collect command-line operands and classify them into directories
+ * and non-directory files.
  *
  * Parameters:
- *   a, b - pointers to file_info_t elements being compared
+ *   argc, argv        - arguments passed to main()
+ *   opts              - parsed options, passed to classify_operands()
+ *   non_dirs          - list receiving non-directory operands (files)
+ *   dirs              - list receiving directory operands
  *
  * Returns:
- *   < 0 if the name of a comes before the name of b
- *   > 0 if the name of a comes after the name of b
- *   = 0 if both names are identical
+ *   The total number of valid non-option operands processed.
  *
- * Notes:
- *   - Uses strcmp() for string comparison
- *   - Intended for use with qsort()
- *   - Declared static as it is internal to this translation unit
+ * Behavior:
+ *   - Skips argv[0] (program name), all option arguments (prefixed with '-')
+ *     and the separate values of long options such as "--jobs 8"
+ *   - Classifies the remaining operands with classify_operands(): one
+ *     stat per operand, batched over the stat pool with --jobs N, with
+ *     the result kept in the operand record for sorting and printing
+ *   - Invalid operands result in an error message and are ignored
+ *   - If no valid non-option operands are provided, defaults to the current
+ *     directory (".")
  */
-static int cmp_file_lex(const void *a, const void *b)
-{
-    const file_info_t *fa = a;
-    const file_info_t *fb = b;
-    return strcmp(fa->name, fb->name);
+int gather_paths(int argc,char** argv,const options_t* opts,operand_list_t* non_dirs,operand_list_t* dirs){
+    char** paths = xmalloc((size_t)argc * sizeof(char*));
+    int count = 0;
+
+    // skip argv[0] --> ./myls
+    for(int i = 1; i < argc; ++i){
+        if(argv[i][0] == '-'){
+            i += option_value_count(argv[i]);
+            continue;
+        }
+        paths[count++] = argv[i];
+    }
+    stats_span_t span;
+    stats_begin(&span);
+    int total = classify_operands(paths, count, opts, non_dirs, dirs);
+    stats_end(&span, STATS_CLASSIFY, (uint64_t)count, NULL);
+    free(paths);
+
+    // no valid non-options args provided, default
+    if(total == 0){
+        operand_t cwd = {".", {.name = ".", .is_dir = true}};
+        operand_list_add(dirs, &cwd);
+        total = 1;
+    }
+    return total;
 }
@@ -1,6 +1,10 @@
 #ifndef MYLS_H
 #define MYLS_H
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include<stdio.h>
 #include<stdbool.h>
 #include<stdlib.h>
@@ -8,8 +12,60 @@
 #include<sys/stat.h>
 #include<string.h>
 #include<limits.h>
+#include<stdint.h>
+#include<fcntl.h>
+#include<errno.h>
+#include<unistd.h>
+
+/*
+ * ST_MTIM
+ * -------
+ * Portable access to the modification timestamp of a struct stat.
+ * BSD/macOS name the field st_mtimespec, POSIX.1-2008 names it st_mtim.
+ */
+#ifdef __APPLE__
+#define ST_MTIM(st) ((st).st_mtimespec)
+#else
+#define ST_MTIM(st) ((st).st_mtim)
+#endif
+
+/*
+ * Stat field masks
+ * ----------------
+ * Fields of an entry's metadata that the active options require.
+ * They are translated to a statx() mask on Linux so the kernel is only
+ * asked for what will actually be used.
+ *
+ *   STAT_NEED_TYPE  - file type (is_dir)
+ *   STAT_NEED_MTIME - modification time (-t, -l)
+ *   STAT_NEED_MODE  - file type and permission bits (-l)
+ *   STAT_NEED_NLINK - link count (-l)
+ *   STAT_NEED_OWNER - owner and group ids (-l)
+ *   STAT_NEED_SIZE  - size, device number and allocated blocks (-l)
+ *
+ * STAT_FOLLOW is not a field but a modifier: resolve a final symbolic
+ * link instead of describing the link itself (command-line operands).
+ */
+#define STAT_NEED_TYPE  0x1u
+#define STAT_NEED_MTIME 0x2u
+#define STAT_NEED_MODE  0x4u
+#define STAT_NEED_NLINK 0x8u
+#define STAT_NEED_OWNER 0x10u
+#define STAT_NEED_SIZE  0x20u
+#define STAT_FOLLOW     0x80u
 
-#define MAX_FILES 2000
+#define ARENA_FIRST_CHUNK 256
+#define ARENA_CHUNK_SIZE (64 * 1024)
+#ifndef OUTPUT_BUF_SIZE
+#define OUTPUT_BUF_SIZE (256 * 1024)
+#endif
+#ifndef READ_AHEAD_MEM_CAP
+#define READ_AHEAD_MEM_CAP (64 * 1024 * 1024)
+#endif
+#ifndef DIRENT_BUF_SIZE
+#define DIRENT_BUF_SIZE (1024 * 1024)
+#endif
+#define FILE_LIST_INITIAL_CAPACITY 64
 /*
  * options_t
  * ---------
@@ -18,10 +74,48 @@
  * Fields:
  *   show_all  (-a): include entries whose names begin with '.'
  *   sort_time (-t): sort entries by modification time
+ *   recursive (-R): list subdirectories recursively
+ *   unsorted (-U, -f): list entries in directory order, streaming them
+ *                      straight to the output when not recursive
+ *   jobs (--jobs N): number of stat calls kept in flight; with -R or
+ *                    several directory operands, number of directory
+ *                    reading workers instead (1 = serial)
+ *   io_uring (--io-uring): stat entries through batched io_uring statx
+ *   limit (--head N, --tail N): list only the first / last N entries of
+ *                               each directory in display order (0 = all)
+ *   limit_tail: set by --tail, selecting the last entries instead
+ *   long_format (-l): one entry per line with mode, links, owner, group,
+ *                     size and modification time
+ *   time_epoch_ns (--time-style=epoch-ns): print -l times as raw
+ *                                          "seconds.nanoseconds"
+ *   columns (-C, -x): 'C' lists names in columns filled top to bottom,
+ *                     'x' across rows, 0 one per line (-1, -l); -C is
+ *                     the default when standard output is a terminal
+ *   line_width: terminal width used by -C / -x (COLUMNS, the terminal
+ *               size reported by ioctl, or 80)
+ *   stats (--stats[=text|json]): 't' or 'j' to report phase timings and
+ *                                counters on stderr, 0 for none
+ *   stats_slowest (--stats-slowest=N): name the N slowest system calls
+ *                                      in the report (implies --stats)
+ *   trace (--trace=FILE): write a Chrome Trace Event timeline to FILE,
+ *                         NULL for none
  */
 typedef struct{
     bool show_all;  // -a
     bool sort_time; // -t
+    bool recursive; // -R
+    bool unsorted;  // -U, -f
+    int jobs;       // --jobs N
+    bool io_uring;  // --io-uring
+    int limit;      // --head N, --tail N
+    bool limit_tail;
+    bool long_format; // -l
+    bool time_epoch_ns; // --time-style=epoch-ns
+    char columns;     // -C, -x
+    int line_width;
+    char stats;       // --stats
+    int stats_slowest;
+    const char* trace; // --trace=FILE
 }options_t;
 
 /*
@@ -31,48 +125,397 @@ typedef struct{
  * collected during directory traversal.
  *
  * Fields:
- *   name   - null-terminated path or entry name (up to PATH_MAX)
+ *   name   - null-terminated entry name; points into the name arena of
+ *            the owning file_list_t and is preceded by its length
+ *            (see entry_name_len)
  *   sec    - modification time in seconds since the Epoch
  *   nsec   - nanosecond component of modification time
  *   is_dir - indicates whether the entry is a directory
+ *   width  - display width of name in columns (see name_width)
+ *   mode, nlink, uid, gid
+ *          - st_mode, st_nlink, st_uid and st_gid (-l only)
+ *   size   - st_size, or st_rdev for character and block devices (-l only)
+ *   blocks - st_blocks, in 512-byte units (-l only)
  *
  * Usage:
  *   - Used to store per-entry metadata required for sorting and display
  *   - Enables time-based sorting (-t) with nanosecond precision
+ *   - The -l fields are only filled when stat_fields() asks for them
  */
 typedef struct{
-    char name[PATH_MAX];
+    const char* name;
     long sec;   // st_mtim.tv_sec
     long nsec;  // st_mtim.tv_nsec
     bool is_dir;
+    uint16_t width;
+    uint32_t mode;
+    uint32_t nlink;
+    uint32_t uid;
+    uint32_t gid;
+    uint64_t size;
+    uint64_t blocks;
 }file_info_t;
 
+/*
+ * operand_t
+ * ---------
+ * A command-line operand, classified by gather_paths().
+ *
+ * Fields:
+ *   path - operand as given on the command line
+ *   info - metadata from the operand's single classification stat, with
+ *          symbolic links followed; info.name is path (not arena-backed)
+ *
+ * Usage:
+ *   - Operand sorting and printing reuse info instead of stat'ing again
+ */
+typedef struct{
+    const char* path;
+    file_info_t info;
+}operand_t;
+
+/*
+ * operand_list_t
+ * --------------
+ * Growable array of operands, filled by classify_operands().
+ *
+ * Fields:
+ *   items    - heap array of operand records, grown geometrically
+ *   count    - number of operands stored
+ *   capacity - number of records the array can hold before growing
+ */
+typedef struct{
+    operand_t* items;
+    int count;
+    int capacity;
+}operand_list_t;
+
+/*
+ * Run statistics (--stats)
+ * ------------------------
+ * Phases timed by stats_begin() / stats_end() and system calls timed by
+ * stats_call_begin() / stats_call_end() (see stats.c).
+ *
+ *   STATS_CLASSIFY - operand classification in gather_paths()
+ *   STATS_READ     - read_directory() / stream_directory()
+ *   STATS_SORT     - sort_file_list() / sort_operands()
+ *   STATS_OUTPUT   - print_entries() / print_operands() and the final flush
+ *
+ * STATS_SYS_URING_STATX covers statx requests completed by io_uring, which
+ * are not individual system calls; their latency runs from queueing to
+ * completion.
+ */
+enum{
+    STATS_CLASSIFY,
+    STATS_READ,
+    STATS_SORT,
+    STATS_OUTPUT,
+    STATS_PHASES
+};
+
+enum{
+    STATS_SYS_OPEN,
+    STATS_SYS_GETDENTS,
+    STATS_SYS_STATX,
+    STATS_SYS_FSTATAT,
+    STATS_SYS_URING_ENTER,
+    STATS_SYS_URING_STATX,
+    STATS_SYS_READLINK,
+    STATS_SYS_WRITE,
+    STATS_SYSCALLS
+};
+
+/*
+ * stats_span_t
+ * ------------
+ * Wall clock and thread CPU time in nanoseconds: the start of an open
+ * span, or accumulated time per phase.
+ */
+typedef struct{
+    uint64_t wall;
+    uint64_t cpu;
+}stats_span_t;
+
+typedef struct dir_stats dir_stats_t;
+
+/*
+ * arena_chunk_t / name_arena_t
+ * ----------------------------
+ * Chunked string arena that owns the names of all entries in a file_list_t.
+ *
+ * Each name is stored length-prefixed and null-terminated:
+ *
+ *     [uint32_t len][len bytes]['\0']
+ *
+ * Chunks are never moved once allocated, so name pointers handed out by
+ * the arena stay valid until the arena is released. Memory grows with the
+ * actual name lengths instead of reserving PATH_MAX bytes per entry.
+ *
+ * Fields:
+ *   head  - chunk currently being filled (older chunks are linked behind it)
+ *   bytes - total bytes reserved across all chunks
+ */
+typedef struct arena_chunk{
+    struct arena_chunk* next;
+    size_t used;
+    size_t cap;
+    char data[];
+}arena_chunk_t;
+
+typedef struct{
+    arena_chunk_t* head;
+    size_t bytes;
+}name_arena_t;
+
 /*
  * file_list_t
  * -----------
- * Container for a collection of filesystem entries and their count.
+ * Growable container for a collection of filesystem entries.
  *
  * Fields:
- *   files - fixed-size array of file_info_t structures representing
- *           files or directories collected during traversal
- *   count - number of valid entries currently stored in the array
+ *   files    - heap array of file_info_t records, grown geometrically
+ *   count    - number of valid entries currently stored in the array
+ *   capacity - number of records the array can hold before growing
+ *   names    - arena owning every entry name referenced from files
+ *   order    - permutation of entry indices produced by sort_file_list(),
+ *              or NULL while the list is unsorted
+ *   stats    - --stats / --trace record of the directory, closed by
+ *              print_entries(); NULL without either option
  *
  * Usage:
- *   - Used to accumulate directory contents before sorting and printing
- *   - Provides a simple abstraction over a raw array of file_info_t
+ *   - Initialise with file_list_init(), append with file_list_add()
+ *   - Visit entries in display order with file_list_at()
+ *   - Release with file_list_free() once the entries have been printed
  */
 typedef struct{
-    file_info_t files[MAX_FILES];
+    file_info_t* files;
     int count;
+    int capacity;
+    name_arena_t names;
+    uint32_t* order;
+    dir_stats_t* stats;
 }file_list_t;
 
+/*
+ * sort_key_t
+ * ----------
+ * Compact sort record built by sort_file_list() for each entry.
+ *
+ * Fields:
+ *   sec, nsec - modification time copied from the entry
+ *   index     - position of the entry in file_list_t.files
+ *   prefix    - next 8 bytes of name, big-endian, zero-padded
+ *   name      - entry name past the prefix common to the whole list
+ *               (points into the list's arena; for comparisons only)
+ *
+ * Usage:
+ *   - Sorting moves these 32-byte keys instead of file_info_t records;
+ *     the sorted indices become the list's display order
+ */
+typedef struct{
+    int64_t sec;
+    int32_t nsec;
+    uint32_t index;
+    uint64_t prefix;
+    const char* name;
+}sort_key_t;
+
+/*
+ * file_list_at
+ * ------------
+ * Return the entry at display position i: through the sort permutation
+ * when the list has been sorted, in filesystem order otherwise.
+ */
+static inline file_info_t* file_list_at(const file_list_t* flist, int i){
+    return &flist->files[flist->order ? flist->order[i] : (uint32_t)i];
+}
+
+/*
+ * dir_reader_t
+ * ------------
+ * State of a batched directory enumeration (see dirread.c).
+ *
+ * Fields:
+ *   fd       - open directory file descriptor, usable with *at() calls
+ *   buf, cap - per-thread getdents64 buffer shared by all readers of a thread
+ *   pos, len - parse position and number of valid bytes in buf
+ *   dir      - directory stream on systems without getdents64
+ */
+typedef struct{
+    int fd;
+#ifdef __linux__
+    char* buf;
+    size_t cap;
+    size_t pos;
+    size_t len;
+#else
+    DIR* dir;
+#endif
+}dir_reader_t;
+
+/*
+ * dir_entry_t
+ * -----------
+ * A single entry produced by dir_reader_next().
+ *
+ * Fields:
+ *   name - null-terminated name, pointing into the reader's buffer
+ *   len  - length of name in bytes
+ *   type - d_type value (DT_UNKNOWN if the filesystem does not report it)
+ */
+typedef struct{
+    const char* name;
+    size_t len;
+    unsigned char type;
+}dir_entry_t;
+
+/*
+ * entry_name_len
+ * --------------
+ * Return the length of an arena-stored name by reading its prefix.
+ */
+static inline size_t entry_name_len(const char* name){
+    uint32_t len;
+    memcpy(&len, name - sizeof(len), sizeof(len));
+    return len;
+}
+
 options_t parse_options(int argc, char** argv);
-int gather_paths(int argc,char** argv,char** non_dirs,int* non_dir_count,char** dirs,int* dir_count);
-void sort_entries(char** entries,int count);
-file_list_t read_directory(const char* path, bool show_hidden);
+int option_value_count(const char* arg);
+int gather_paths(int argc,char** argv,const options_t* opts,operand_list_t* non_dirs,operand_list_t* dirs);
+
+// listing.c
+unsigned stat_fields(const options_t* opts);
+bool needs_metadata(const options_t* opts);
+file_list_t read_directory(const char* path, const options_t* opts);
+int stream_directory(const char* path, const options_t* opts);
+
+// operands.c
+void operand_list_init(operand_list_t* list);
+void operand_list_add(operand_list_t* list, const operand_t* op);
+void operand_list_free(operand_list_t* list);
+int classify_operands(char** paths, int count, const options_t* opts,
+                      operand_list_t* non_dirs, operand_list_t* dirs);
+
+// pipeline.c
+int read_ahead_start(const operand_t* dirs, int count, const options_t* opts);
+file_list_t read_ahead_take(int i);
+void read_ahead_stop(void);
+
+// recurse.c
+void traverse_start(const options_t* opts);
+void traverse_stop(void);
+void list_recursive(const char* path, bool* printed);
+
+// topk.c
+file_list_t read_directory_topk(const char* path, const options_t* opts);
+
+// sort.c
+void sort_operands(operand_t* ops, int count, bool sort_time);
 void sort_file_list(file_list_t *flist, bool sort_time);
-static int cmp_file_time(const void *a, const void *b);
-static int cmp_file_lex(const void *a, const void *b);
+
+// store.c
+void* xmalloc(size_t size);
+void* xrealloc(void* ptr, size_t size);
+uint16_t name_width(const char* name, size_t len);
+size_t file_list_bytes(const file_list_t* flist);
+void file_list_init(file_list_t* flist);
+file_info_t* file_list_add(file_list_t* flist, const char* name, size_t len);
+void file_list_free(file_list_t* flist);
+void file_list_drop_failed(file_list_t* flist, const bool* failed);
+arena_chunk_t* file_list_detach_names(file_list_t* flist);
+
+// dirread.c
+char* dir_buffer_get(size_t size, size_t* cap);
+void dir_buffer_release(void);
+int dir_reader_open(dir_reader_t* reader, const char* path, size_t buf_size);
+int dir_reader_next(dir_reader_t* reader, dir_entry_t* out);
+void dir_reader_close(dir_reader_t* reader);
+
+// format.c
+void print_entries(const file_list_t* flist, const char* dir, const options_t* opts);
+void print_operands(const operand_t* ops, int count, const operand_t* dirs, int dir_count,
+                    const options_t* opts);
+
+// statpool.c
+#ifdef STATX_TYPE
+unsigned statx_mask(unsigned fields);
+void statx_fill(file_info_t* info, const struct statx* stx);
+#endif
+int stat_entry(int dfd, const char* name, unsigned fields, file_info_t* info);
+void stat_pool_start(int jobs);
+void stat_pool_stop(void);
+void stat_pool_batch(int dfd, file_info_t* files, int count, unsigned fields, bool* failed);
+void stat_pool_run(int dfd, file_list_t* flist, unsigned fields);
+
+// output.c
+void out_init(int fd, size_t cap);
+void out_write(const char* data, size_t len);
+void out_char(char c);
+void out_line(const char* name, size_t len);
+void out_spaces(size_t n);
+void out_uint(uint64_t value, int width);
+int uint_digits(uint64_t value);
+int out_flush(void);
+
+// stats.c
+extern bool stats_enabled;
+void stats_start(char format, int slowest);
+uint64_t stats_clock(void);
+void stats_begin(stats_span_t* span);
+void stats_end(const stats_span_t* span, int phase, uint64_t items, dir_stats_t* dir);
+void stats_set_dir(const char* dir);
+const char* stats_dir(void);
+void stats_record_call(int sys, uint64_t start, const char* name);
+void stats_written(uint64_t bytes);
+void stats_store(int64_t delta);
+dir_stats_t* stats_dir_open(const char* path);
+void stats_dir_close(dir_stats_t* dir, size_t store_bytes);
+void stats_report(void);
+void json_string(FILE* f, const char* s);
+
+/*
+ * stats_call_begin / stats_call_end
+ * ---------------------------------
+ * Bracket one system call for --stats: stats_call_end() counts it and
+ * records its latency for the histograms and the slowest-call list, where
+ * it is named by name (relative to stats_dir(), NULL for the directory
+ * itself). Both are a single branch without --stats.
+ */
+static inline uint64_t stats_call_begin(void){
+    return stats_enabled ? stats_clock() : 0;
+}
+
+static inline void stats_call_end(int sys, uint64_t start, const char* name){
+    if(stats_enabled)
+        stats_record_call(sys, start, name);
+}
+
+// trace.c
+extern bool trace_enabled;
+int trace_start(const char* path);
+void trace_span(const char* name, const char* detail, uint64_t items, uint64_t start);
+void trace_finish(void);
+
+/*
+ * trace_begin / trace_end
+ * -----------------------
+ * Bracket a trace-only span (stat batches, output flushes); a single
+ * branch without --trace. Phase spans are traced through stats_end().
+ */
+static inline uint64_t trace_begin(void){
+    return trace_enabled ? stats_clock() : 0;
+}
+
+static inline void trace_end(const char* name, const char* detail, uint64_t items, uint64_t start){
+    if(trace_enabled)
+        trace_span(name, detail, items, start);
+}
+
+// uring.c
+int uring_start(void);
+void uring_stop(void);
+int uring_stat_run(int dfd, file_list_t* flist, unsigned fields);
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,128 @@
+/*
+ * Operands
+ * --------
+ * Storage and classification of command-line operands.
+ *
+ * Operands are kept in growable heap lists rather than arrays sized by
+ * argc on the stack, so argument lists of any length (e.g. fed by xargs)
+ * are safe. Classification stats every operand once, as one batch: with
+ * --jobs N the batch is spread over the stat pool, otherwise the calling
+ * thread works through it. The results are then split into files and
+ * directories in argument order, so output and error messages do not
+ * depend on the number of workers.
+ */
+
+#include "myls.h"
+
+/*
+ * operand_list_init
+ * -----------------
+ * Initialise an empty operand_list_t. No memory is allocated until the
+ * first operand is added.
+ */
+void operand_list_init(operand_list_t* list){
+    list->items = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+/*
+ * operand_list_add
+ * ----------------
+ * Append a copy of an operand record, doubling the array when it is full.
+ */
+void operand_list_add(operand_list_t* list, const operand_t* op){
+    if(list->count == list->capacity){
+        int cap = list->capacity ? list->capacity * 2 : FILE_LIST_INITIAL_CAPACITY;
+        list->items = xrealloc(list->items, (size_t)cap * sizeof(operand_t));
+        list->capacity = cap;
+    }
+    list->items[list->count++] = *op;
+}
+
+/*
+ * operand_list_free
+ * -----------------
+ * Release the record array. The paths are not owned by the list.
+ */
+void operand_list_free(operand_list_t* list){
+    free(list->items);
+    operand_list_init(list);
+}
+
+/*
+ * classify_operands
+ * -----------------
+ * Stat command-line operands and split them into files and directories.
+ *
+ * Parameters:
+ *   paths    - operand paths in argument order (must outlive the lists)
+ *   count    - number of paths
+ *   opts     - parsed options; stat_fields() decides which metadata is
+ *              captured for every operand
+ *   non_dirs - list receiving non-directory operands
+ *   dirs     - list receiving directory operands
+ *
+ * Returns:
+ *   The number of operands that could be classified.
+ *
+ * Behavior:
+ *   - Stats all operands without following symbolic links in one
+ *     stat_pool_batch() call, then stats the links among them once more
+ *     following them (a second batch)
+ *   - Like GNU ls, a link to a directory is listed as that directory,
+ *     with its target's metadata; any other link keeps its own metadata
+ *     and is listed as a file. With -l no link is followed
+ *   - Reports operands that do not exist and leaves them out
+ *   - Appends to the lists in argument order
+ */
+int classify_operands(char** paths, int count, const options_t* opts,
+                      operand_list_t* non_dirs, operand_list_t* dirs){
+    unsigned fields = stat_fields(opts);
+    file_info_t* infos = xmalloc((size_t)(count ? count : 1) * sizeof(file_info_t));
+    bool* failed = xmalloc((size_t)(count ? count : 1) * sizeof(bool));
+    for(int i = 0; i < count; ++i){
+        memset(&infos[i], 0, sizeof(infos[i]));
+        infos[i].name = paths[i];
+        infos[i].width = name_width(paths[i], strlen(paths[i]));
+    }
+    stat_pool_batch(AT_FDCWD, infos, count, fields, failed);
+
+    // -l describes symbolic links themselves, like GNU ls
+    if(!opts->long_format){
+        int* links = xmalloc((size_t)(count ? count : 1) * sizeof(int));
+        int nlinks = 0;
+        for(int i = 0; i < count; ++i)
+            if(!failed[i] && S_ISLNK(infos[i].mode))
+                links[nlinks++] = i;
+        if(nlinks){
+            file_info_t* targets = xmalloc((size_t)nlinks * sizeof(file_info_t));
+            bool* dangling = xmalloc((size_t)nlinks * sizeof(bool));
+            for(int k = 0; k < nlinks; ++k)
+                targets[k] = infos[links[k]];
+            stat_pool_batch(AT_FDCWD, targets, nlinks, fields | STAT_FOLLOW, dangling);
+            for(int k = 0; k < nlinks; ++k)
+                if(!dangling[k] && targets[k].is_dir)
+                    infos[links[k]] = targets[k];
+            free(dangling);
+            free(targets);
+        }
+        free(links);
+    }
+
+    int valid = 0;
+    for(int i = 0; i < count; ++i){
+        if(failed[i]){
+            // invalid
+            out_write("myls: cannot access -- ", 23);
+            out_line(paths[i], strlen(paths[i]));
+            continue;
+        }
+        operand_t op = {paths[i], infos[i]};
+        operand_list_add(op.info.is_dir ? dirs : non_dirs, &op);
+        valid++;
+    }
+    free(failed);
+    free(infos);
+    return valid;
+}
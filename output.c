@@ -0,0 +1,214 @@
+/*
+ * Output Layer
+ * ------------
+ * Buffered writer for everything myls prints to standard output.
+ *
+ * Names are appended to a large user-space buffer with memcpy and known
+ * lengths, so no format string is parsed and no stdio lock is taken per
+ * line. The buffer is handed to the kernel with write() when it fills up
+ * and once more at the end of the run; a payload larger than the free
+ * space is sent together with the pending buffer in a single writev().
+ */
+
+#include "myls.h"
+#include<unistd.h>
+#include<sys/uio.h>
+
+static struct{
+    int fd;
+    char* buf;
+    size_t len;
+    size_t cap;
+    bool failed;
+}out = { .fd = STDOUT_FILENO };
+
+/*
+ * write_all
+ * ---------
+ * Write an iovec array completely, retrying on short writes and EINTR.
+ *
+ * Returns:
+ *   0 on success, -1 on a write error.
+ */
+static int write_all(struct iovec* iov, int iovcnt){
+    while(iovcnt > 0){
+        uint64_t start = stats_call_begin();
+        ssize_t n = writev(out.fd, iov, iovcnt);
+        stats_call_end(STATS_SYS_WRITE, start, NULL);
+        if(n < 0){
+            if(errno == EINTR)
+                continue;
+            return -1;
+        }
+        stats_written((uint64_t)n);
+        // skip fully written vectors, advance into a partial one
+        while(iovcnt > 0 && (size_t)n >= iov->iov_len){
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if(iovcnt > 0){
+            iov->iov_base = (char*)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+    return 0;
+}
+
+/*
+ * out_send
+ * --------
+ * Send the pending buffer followed by an optional extra payload.
+ */
+static void out_send(const char* extra, size_t extra_len){
+    uint64_t start = trace_begin();
+    struct iovec iov[2];
+    int iovcnt = 0;
+    if(out.len){
+        iov[iovcnt].iov_base = out.buf;
+        iov[iovcnt].iov_len = out.len;
+        iovcnt++;
+    }
+    if(extra_len){
+        iov[iovcnt].iov_base = (void*)extra;
+        iov[iovcnt].iov_len = extra_len;
+        iovcnt++;
+    }
+    if(!out.failed && write_all(iov, iovcnt)){
+        fprintf(stderr, "myls: write error: %s\n", strerror(errno));
+        out.failed = true;
+    }
+    trace_end("flush", NULL, out.len + extra_len, start);
+    out.len = 0;
+}
+
+/*
+ * out_init
+ * --------
+ * Allocate the output buffer for the given file descriptor.
+ *
+ * Parameters:
+ *   fd  - destination, normally STDOUT_FILENO
+ *   cap - buffer size in bytes; 0 selects OUTPUT_BUF_SIZE
+ */
+void out_init(int fd, size_t cap){
+    out.fd = fd;
+    out.cap = cap ? cap : OUTPUT_BUF_SIZE;
+    out.buf = xmalloc(out.cap);
+    out.len = 0;
+    out.failed = false;
+}
+
+/*
+ * out_write
+ * ---------
+ * Append len bytes to the output.
+ *
+ * Behavior:
+ *   - Copies into the buffer when the data fits
+ *   - Otherwise flushes; data at least as large as the whole buffer is
+ *     written directly together with the pending bytes in one writev()
+ */
+void out_write(const char* data, size_t len){
+    if(out.cap - out.len < len){
+        if(len >= out.cap){
+            out_send(data, len);
+            return;
+        }
+        out_send(NULL, 0);
+    }
+    memcpy(out.buf + out.len, data, len);
+    out.len += len;
+}
+
+/*
+ * out_char
+ * --------
+ * Append a single byte to the output.
+ */
+void out_char(char c){
+    if(out.len == out.cap)
+        out_send(NULL, 0);
+    out.buf[out.len++] = c;
+}
+
+/*
+ * out_line
+ * --------
+ * Append a name of known length followed by a newline.
+ */
+void out_line(const char* name, size_t len){
+    if(out.cap - out.len > len){
+        memcpy(out.buf + out.len, name, len);
+        out.buf[out.len + len] = '\n';
+        out.len += len + 1;
+        return;
+    }
+    out_write(name, len);
+    out_char('\n');
+}
+
+/*
+ * out_spaces
+ * ----------
+ * Append n spaces (column padding).
+ */
+void out_spaces(size_t n){
+    static const char spaces[32] = "                                ";
+    while(n > 0){
+        size_t chunk = n < sizeof(spaces) ? n : sizeof(spaces);
+        out_write(spaces, chunk);
+        n -= chunk;
+    }
+}
+
+/*
+ * uint_digits
+ * -----------
+ * Number of decimal digits needed to print value.
+ */
+int uint_digits(uint64_t value){
+    int digits = 1;
+    while(value >= 10){
+        value /= 10;
+        digits++;
+    }
+    return digits;
+}
+
+/*
+ * out_uint
+ * --------
+ * Append an unsigned integer in decimal, right-aligned in width columns.
+ *
+ * Notes:
+ *   - Digits are produced back to front into a small buffer, so no format
+ *     string is parsed per number
+ */
+void out_uint(uint64_t value, int width){
+    char buf[20];
+    char* p = buf + sizeof(buf);
+    do{
+        *--p = (char)('0' + value % 10);
+        value /= 10;
+    }while(value);
+    int len = (int)(buf + sizeof(buf) - p);
+    if(width > len)
+        out_spaces((size_t)(width - len));
+    out_write(p, (size_t)len);
+}
+
+/*
+ * out_flush
+ * ---------
+ * Write out everything buffered so far.
+ *
+ * Returns:
+ *   0 if all output so far reached the file descriptor, -1 if any write
+ *   failed during the run (reported once on stderr).
+ */
+int out_flush(void){
+    if(out.len)
+        out_send(NULL, 0);
+    return out.failed ? -1 : 0;
+}
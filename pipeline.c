@@ -0,0 +1,173 @@
+/*
+ * Read-ahead Pipeline
+ * -------------------
+ * Ordered reorder buffer used by main() when several directory operands
+ * are listed with --jobs N.
+ *
+ * Background workers claim operands in increasing index order, read and
+ * sort them, and park the finished lists in a reorder buffer keyed by
+ * operand index. The printer takes results strictly in operand order with
+ * read_ahead_take(), so output is identical to the serial loop while later
+ * directories are already being read as earlier ones are printed.
+ *
+ * The buffer is capped at READ_AHEAD_MEM_CAP bytes of entry storage.
+ * Once the cap is reached, workers stop claiming new operands until the
+ * printer has released memory; the operand the printer is waiting for
+ * can always be claimed, so the pipeline never stalls on the cap.
+ */
+
+#include "myls.h"
+#include<pthread.h>
+
+/*
+ * ready_slot_t
+ * ------------
+ * Reorder buffer slot for one operand.
+ *
+ * Fields:
+ *   list  - sorted entries, valid once ready is set
+ *   bytes - memory charged against the cap for this list
+ *   ready - set by the worker that read the operand
+ */
+typedef struct{
+    file_list_t list;
+    size_t bytes;
+    bool ready;
+}ready_slot_t;
+
+static struct{
+    pthread_t* threads;
+    int nthreads;
+    options_t opts;         // options as seen by workers (no nested pools)
+    const operand_t* dirs;
+    int count;
+
+    pthread_mutex_t lock;
+    pthread_cond_t ready_cv; // a slot became ready
+    pthread_cond_t space_cv; // the printer released memory or advanced
+    ready_slot_t* slots;
+    int next_claim;          // next operand a worker may read
+    int next_print;          // operand the printer needs next
+    size_t buffered;         // bytes held by ready, unprinted slots
+}rb = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .ready_cv = PTHREAD_COND_INITIALIZER,
+    .space_cv = PTHREAD_COND_INITIALIZER,
+};
+
+static void* read_ahead_worker(void* arg){
+    (void)arg;
+    for(;;){
+        pthread_mutex_lock(&rb.lock);
+        while(rb.next_claim < rb.count && rb.next_claim != rb.next_print &&
+              rb.buffered >= READ_AHEAD_MEM_CAP)
+            pthread_cond_wait(&rb.space_cv, &rb.lock);
+        if(rb.next_claim >= rb.count){
+            pthread_mutex_unlock(&rb.lock);
+            break;
+        }
+        int i = rb.next_claim++;
+        pthread_mutex_unlock(&rb.lock);
+
+        file_list_t flist = read_directory(rb.dirs[i].path, &rb.opts);
+        if(!rb.opts.unsorted)
+            sort_file_list(&flist, rb.opts.sort_time);
+        size_t bytes = file_list_bytes(&flist);
+
+        pthread_mutex_lock(&rb.lock);
+        rb.slots[i].list = flist;
+        rb.slots[i].bytes = bytes;
+        rb.slots[i].ready = true;
+        rb.buffered += bytes;
+        pthread_cond_broadcast(&rb.ready_cv);
+        pthread_mutex_unlock(&rb.lock);
+    }
+    dir_buffer_release();
+    return NULL;
+}
+
+/*
+ * read_ahead_start
+ * ----------------
+ * Start reading directory operands in the background.
+ *
+ * Parameters:
+ *   dirs  - directory operands in print order (must outlive the pipeline)
+ *   count - number of operands
+ *   opts  - parsed options; opts->jobs worker threads are started
+ *
+ * Returns:
+ *   0 on success, -1 if no worker could be started (the caller then
+ *   reads the operands itself).
+ */
+int read_ahead_start(const operand_t* dirs, int count, const options_t* opts){
+    rb.opts = *opts;
+    rb.opts.jobs = 1;
+    rb.opts.io_uring = false;
+    rb.dirs = dirs;
+    rb.count = count;
+    rb.next_claim = 0;
+    rb.next_print = 0;
+    rb.buffered = 0;
+    rb.slots = xmalloc((size_t)count * sizeof(ready_slot_t));
+    for(int i = 0; i < count; ++i)
+        rb.slots[i].ready = false;
+
+    int nthreads = opts->jobs < count ? opts->jobs : count;
+    rb.threads = xmalloc((size_t)nthreads * sizeof(pthread_t));
+    rb.nthreads = 0;
+    while(rb.nthreads < nthreads &&
+          !pthread_create(&rb.threads[rb.nthreads], NULL, read_ahead_worker, NULL))
+        rb.nthreads++;
+    if(rb.nthreads == 0){
+        free(rb.threads);
+        free(rb.slots);
+        rb.threads = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * read_ahead_take
+ * ---------------
+ * Return the sorted entries of operand i, waiting until it has been read.
+ *
+ * Parameters:
+ *   i - operand index; must be called with 0, 1, 2, ... in order
+ *
+ * Returns:
+ *   The list, now owned by the caller (release with file_list_free()).
+ *
+ * Notes:
+ *   - Taking a result releases its memory from the cap and lets workers
+ *     claim further operands
+ */
+file_list_t read_ahead_take(int i){
+    pthread_mutex_lock(&rb.lock);
+    rb.next_print = i;
+    pthread_cond_broadcast(&rb.space_cv);
+    while(!rb.slots[i].ready)
+        pthread_cond_wait(&rb.ready_cv, &rb.lock);
+    file_list_t flist = rb.slots[i].list;
+    rb.buffered -= rb.slots[i].bytes;
+    rb.next_print = i + 1;
+    pthread_cond_broadcast(&rb.space_cv);
+    pthread_mutex_unlock(&rb.lock);
+    return flist;
+}
+
+/*
+ * read_ahead_stop
+ * ---------------
+ * Join the workers once every operand has been taken.
+ */
+void read_ahead_stop(void){
+    for(int i = 0; i < rb.nthreads; ++i)
+        pthread_join(rb.threads[i], NULL);
+    free(rb.threads);
+    free(rb.slots);
+    rb.threads = NULL;
+    rb.slots = NULL;
+    rb.nthreads = 0;
+}
@@ -0,0 +1,444 @@
+/*
+ * Recursive Listing (-R)
+ * ----------------------
+ * Traversal engine behind -R.
+ *
+ * Every directory becomes a dir_node_t. Reading a node means calling
+ * read_directory() and sort_file_list() on its path, then creating one
+ * child node per subdirectory, in display order.
+ *
+ * With --jobs N (N > 1), nodes are read by N worker threads that schedule
+ * work by stealing: each worker owns a deque of nodes, pushes the children
+ * it discovers onto the bottom of its own deque and pops from the bottom
+ * (depth first, warm caches), while idle workers steal from the top of
+ * other deques, where the oldest and typically largest subtrees are.
+ *
+ * Output never depends on that schedule. The printer walks the node tree
+ * depth first in display order, exactly as GNU ls -R does, waiting for
+ * each node to be read before printing it and freeing it afterwards.
+ * Without --jobs, the printer reads each node itself when it reaches it.
+ *
+ * Nodes that are read but not yet printed are capped at READ_AHEAD_MEM_CAP
+ * bytes of entry storage, like the read-ahead pipeline. Once the cap is
+ * reached, workers stop taking new nodes until the printer has released
+ * memory. A node is claimed by whoever reads it, and the printer reads
+ * the node it needs itself if no worker has claimed it, so the traversal
+ * never stalls on the cap.
+ */
+
+#include "myls.h"
+#include<pthread.h>
+#include<stdatomic.h>
+
+/*
+ * dir_node_t
+ * ----------
+ * One directory of a recursive listing.
+ *
+ * Fields:
+ *   path        - heap-allocated path used for reading and the header
+ *   list        - sorted entries, valid once done is set
+ *   children    - nodes for the subdirectories, in display order
+ *   child_count - number of children
+ *   bytes       - memory of list charged against the cap until printed
+ *   done        - set (under sched.lock) once list and children are ready
+ *   claimed     - set by the thread that reads the node
+ *   refs        - owners of the struct: the tree, plus one per deque entry
+ *                 (an entry outlives the node when the printer read it)
+ */
+typedef struct dir_node{
+    char* path;
+    file_list_t list;
+    struct dir_node** children;
+    int child_count;
+    size_t bytes;
+    bool done;
+    atomic_bool claimed;
+    atomic_int refs;
+}dir_node_t;
+
+/*
+ * task_deque_t
+ * ------------
+ * Per-worker deque of nodes waiting to be read. The owner pushes and pops
+ * at the tail; thieves take from the head.
+ */
+typedef struct{
+    pthread_mutex_t lock;
+    dir_node_t** items;
+    int head;
+    int tail;
+    int cap;
+}task_deque_t;
+
+static struct{
+    task_deque_t* deques;
+    pthread_t* threads;
+    int nworkers;
+    options_t opts;         // options as seen by workers (no nested pools)
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_cv; // new tasks or shutdown
+    pthread_cond_t done_cv; // a node finished reading
+    pthread_cond_t space_cv; // the printer released memory, or shutdown
+    size_t buffered;        // bytes held by read, unprinted nodes
+    atomic_int queued;      // nodes sitting in any deque
+    int idle;               // workers waiting on work_cv
+    bool stopping;
+}sched = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work_cv = PTHREAD_COND_INITIALIZER,
+    .done_cv = PTHREAD_COND_INITIALIZER,
+    .space_cv = PTHREAD_COND_INITIALIZER,
+};
+
+static __thread int worker_id = -1;
+
+/*
+ * node_new
+ * --------
+ * Allocate an unread node for path (the string is taken over).
+ */
+static dir_node_t* node_new(char* path){
+    dir_node_t* node = xmalloc(sizeof(dir_node_t));
+    node->path = path;
+    file_list_init(&node->list);
+    node->children = NULL;
+    node->child_count = 0;
+    node->bytes = 0;
+    node->done = false;
+    atomic_init(&node->claimed, false);
+    atomic_init(&node->refs, 1);
+    return node;
+}
+
+// take the right to read a node; false if another thread already has it
+static bool node_claim(dir_node_t* node){
+    return !atomic_exchange(&node->claimed, true);
+}
+
+// drop one reference to the node struct, freeing it with the last one
+static void node_release(dir_node_t* node){
+    if(atomic_fetch_sub(&node->refs, 1) == 1)
+        free(node);
+}
+
+/*
+ * join_path
+ * ---------
+ * Build "parent/name" on the heap, without doubling a trailing '/'
+ * of parent (matching GNU ls headers).
+ */
+static char* join_path(const char* parent, const char* name, size_t name_len){
+    size_t plen = strlen(parent);
+    bool slash = plen > 0 && parent[plen - 1] == '/';
+    char* path = xmalloc(plen + !slash + name_len + 1);
+    memcpy(path, parent, plen);
+    if(!slash)
+        path[plen++] = '/';
+    memcpy(path + plen, name, name_len);
+    path[plen + name_len] = '\0';
+    return path;
+}
+
+static void deque_push(task_deque_t* dq, dir_node_t* node){
+    pthread_mutex_lock(&dq->lock);
+    if(dq->tail == dq->cap){
+        // slide live items to the front, grow if still full
+        int live = dq->tail - dq->head;
+        if(live > 0)
+            memmove(dq->items, dq->items + dq->head, (size_t)live * sizeof(dir_node_t*));
+        dq->head = 0;
+        dq->tail = live;
+        if(live == dq->cap){
+            dq->cap = dq->cap ? dq->cap * 2 : 64;
+            dq->items = xrealloc(dq->items, (size_t)dq->cap * sizeof(dir_node_t*));
+        }
+    }
+    dq->items[dq->tail++] = node;
+    pthread_mutex_unlock(&dq->lock);
+}
+
+static dir_node_t* deque_pop(task_deque_t* dq){
+    dir_node_t* node = NULL;
+    pthread_mutex_lock(&dq->lock);
+    if(dq->tail > dq->head)
+        node = dq->items[--dq->tail];
+    pthread_mutex_unlock(&dq->lock);
+    return node;
+}
+
+static dir_node_t* deque_steal(task_deque_t* dq){
+    dir_node_t* node = NULL;
+    pthread_mutex_lock(&dq->lock);
+    if(dq->tail > dq->head)
+        node = dq->items[dq->head++];
+    pthread_mutex_unlock(&dq->lock);
+    return node;
+}
+
+/*
+ * schedule_node
+ * -------------
+ * Queue a node on the calling worker's deque (deque 0 for the printer)
+ * and wake an idle worker if there is one. The deque entry holds its own
+ * reference to the node.
+ */
+static void schedule_node(dir_node_t* node){
+    int id = worker_id >= 0 ? worker_id : 0;
+    atomic_fetch_add(&node->refs, 1);
+    deque_push(&sched.deques[id], node);
+    atomic_fetch_add(&sched.queued, 1);
+
+    pthread_mutex_lock(&sched.lock);
+    if(sched.idle > 0)
+        pthread_cond_signal(&sched.work_cv);
+    pthread_mutex_unlock(&sched.lock);
+}
+
+/*
+ * read_node
+ * ---------
+ * Read and sort a node's directory and create its children.
+ *
+ * Parameters:
+ *   node     - node to read
+ *   opts     - options passed to read_directory()
+ *   schedule - queue the children for the workers (parallel mode)
+ *
+ * Behavior:
+ *   - Children are created for directory entries in display order,
+ *     skipping "." and ".."; symbolic links are never followed
+ *   - Children are pushed in reverse so the owner pops the first one next
+ *   - Charges the list against the cap, marks the node done and wakes
+ *     the printer
+ */
+static void read_node(dir_node_t* node, const options_t* opts, bool schedule){
+    node->list = read_directory(node->path, opts);
+    if(!opts->unsorted)
+        sort_file_list(&node->list, opts->sort_time);
+
+    int subdirs = 0;
+    for(int i = 0; i < node->list.count; ++i)
+        if(node->list.files[i].is_dir)
+            subdirs++;
+    if(subdirs)
+        node->children = xmalloc((size_t)subdirs * sizeof(dir_node_t*));
+
+    for(int i = 0; i < node->list.count; ++i){
+        const file_info_t* info = file_list_at(&node->list, i);
+        if(!info->is_dir || !strcmp(info->name, ".") || !strcmp(info->name, ".."))
+            continue;
+        char* path = join_path(node->path, info->name, entry_name_len(info->name));
+        node->children[node->child_count++] = node_new(path);
+    }
+
+    if(schedule)
+        for(int i = node->child_count - 1; i >= 0; --i)
+            schedule_node(node->children[i]);
+
+    node->bytes = file_list_bytes(&node->list);
+    pthread_mutex_lock(&sched.lock);
+    sched.buffered += node->bytes;
+    node->done = true;
+    pthread_cond_broadcast(&sched.done_cv);
+    pthread_mutex_unlock(&sched.lock);
+}
+
+/*
+ * find_work
+ * ---------
+ * Pop from the worker's own deque, or steal from the others starting
+ * with the next worker. The caller owns the deque entry's reference.
+ */
+static dir_node_t* find_work(int id){
+    dir_node_t* node = deque_pop(&sched.deques[id]);
+    for(int k = 1; !node && k < sched.nworkers; ++k)
+        node = deque_steal(&sched.deques[(id + k) % sched.nworkers]);
+    if(node)
+        atomic_fetch_sub(&sched.queued, 1);
+    return node;
+}
+
+static void* traverse_worker(void* arg){
+    worker_id = (int)(intptr_t)arg;
+
+    for(;;){
+        // over the cap: wait for the printer to release memory
+        pthread_mutex_lock(&sched.lock);
+        while(!sched.stopping && sched.buffered >= READ_AHEAD_MEM_CAP)
+            pthread_cond_wait(&sched.space_cv, &sched.lock);
+        pthread_mutex_unlock(&sched.lock);
+
+        dir_node_t* node = find_work(worker_id);
+        if(node){
+            // the printer may have read it already
+            if(node_claim(node))
+                read_node(node, &sched.opts, true);
+            node_release(node);
+            continue;
+        }
+
+        pthread_mutex_lock(&sched.lock);
+        sched.idle++;
+        while(!sched.stopping && atomic_load(&sched.queued) == 0)
+            pthread_cond_wait(&sched.work_cv, &sched.lock);
+        sched.idle--;
+        bool stop = sched.stopping;
+        pthread_mutex_unlock(&sched.lock);
+        if(stop)
+            break;
+    }
+    dir_buffer_release();
+    return NULL;
+}
+
+/*
+ * traverse_start
+ * --------------
+ * Start the traversal workers for -R.
+ *
+ * Parameters:
+ *   opts - parsed options; opts->jobs workers are started when it is
+ *          greater than 1, otherwise traversal stays on the calling thread
+ *
+ * Notes:
+ *   - Workers stat serially inside read_directory(): the traversal itself
+ *     supplies the parallelism, so nested stat pools and the io_uring
+ *     engine are disabled once the workers are running (main() does not
+ *     start the ring for -R --jobs N)
+ *   - Serial traversal keeps the options as given, so -R --io-uring and
+ *     the stat pool of --jobs N (if no worker could be started) apply
+ */
+void traverse_start(const options_t* opts){
+    sched.opts = *opts;
+    if(opts->jobs <= 1)
+        return;
+
+    sched.deques = xmalloc((size_t)opts->jobs * sizeof(task_deque_t));
+    for(int i = 0; i < opts->jobs; ++i){
+        pthread_mutex_init(&sched.deques[i].lock, NULL);
+        sched.deques[i].items = NULL;
+        sched.deques[i].head = sched.deques[i].tail = sched.deques[i].cap = 0;
+    }
+
+    // workers must see the final count, so it is only raised afterwards
+    sched.threads = xmalloc((size_t)opts->jobs * sizeof(pthread_t));
+    sched.nworkers = opts->jobs;
+    int started = 0;
+    while(started < opts->jobs &&
+          !pthread_create(&sched.threads[started], NULL, traverse_worker, (void*)(intptr_t)started))
+        started++;
+    if(started < opts->jobs){
+        // could not start every worker: keep the serial traversal
+        pthread_mutex_lock(&sched.lock);
+        sched.stopping = true;
+        pthread_cond_broadcast(&sched.work_cv);
+        pthread_mutex_unlock(&sched.lock);
+        for(int i = 0; i < started; ++i)
+            pthread_join(sched.threads[i], NULL);
+        free(sched.threads);
+        sched.threads = NULL;
+        sched.stopping = false;
+        return;
+    }
+    sched.opts.jobs = 1;
+    sched.opts.io_uring = false;
+}
+
+/*
+ * traverse_stop
+ * -------------
+ * Stop and join the workers. Safe to call when none were started.
+ */
+void traverse_stop(void){
+    if(!sched.threads)
+        return;
+    pthread_mutex_lock(&sched.lock);
+    sched.stopping = true;
+    pthread_cond_broadcast(&sched.work_cv);
+    pthread_cond_broadcast(&sched.space_cv);
+    pthread_mutex_unlock(&sched.lock);
+
+    for(int i = 0; i < sched.nworkers; ++i)
+        pthread_join(sched.threads[i], NULL);
+    for(int i = 0; i < sched.nworkers; ++i){
+        pthread_mutex_destroy(&sched.deques[i].lock);
+        free(sched.deques[i].items);
+    }
+    free(sched.deques);
+    free(sched.threads);
+    sched.threads = NULL;
+}
+
+/*
+ * list_recursive
+ * --------------
+ * Print a directory operand and all of its subdirectories (-R).
+ *
+ * Parameters:
+ *   path    - directory operand
+ *   printed - in/out: whether anything has been printed before; a blank
+ *             line separates every directory block from the previous one
+ *
+ * Behavior:
+ *   - Prints "path:" followed by the entries of each directory, depth
+ *     first in display order (the same order GNU ls -R uses)
+ *   - Nodes are read by the workers in any order; the printer reads the
+ *     next node it needs itself if no worker has claimed it, waits for it
+ *     otherwise, and frees each node once printed, releasing its memory
+ *     from the cap
+ */
+void list_recursive(const char* path, bool* printed){
+    bool parallel = sched.threads != NULL;
+    size_t len = strlen(path);
+    char* root_path = xmalloc(len + 1);
+    memcpy(root_path, path, len + 1);
+    dir_node_t* root = node_new(root_path);
+    if(parallel)
+        schedule_node(root);
+
+    // explicit stack of nodes still to print
+    int cap = 64, top = 0;
+    dir_node_t** stack = xmalloc((size_t)cap * sizeof(dir_node_t*));
+    stack[top++] = root;
+
+    while(top > 0){
+        dir_node_t* node = stack[--top];
+
+        if(parallel && !node_claim(node)){
+            pthread_mutex_lock(&sched.lock);
+            while(!node->done)
+                pthread_cond_wait(&sched.done_cv, &sched.lock);
+            pthread_mutex_unlock(&sched.lock);
+        }
+        else
+            read_node(node, &sched.opts, parallel);
+
+        if(*printed)
+            out_char('\n');
+        out_write(node->path, strlen(node->path));
+        out_write(":\n", 2);
+        print_entries(&node->list, node->path, &sched.opts);
+        *printed = true;
+
+        // children are printed next, first child on top
+        if(top + node->child_count > cap){
+            while(top + node->child_count > cap)
+                cap *= 2;
+            stack = xrealloc(stack, (size_t)cap * sizeof(dir_node_t*));
+        }
+        for(int i = node->child_count - 1; i >= 0; --i)
+            stack[top++] = node->children[i];
+
+        file_list_free(&node->list);
+        free(node->children);
+        free(node->path);
+        pthread_mutex_lock(&sched.lock);
+        sched.buffered -= node->bytes;
+        pthread_cond_broadcast(&sched.space_cv);
+        pthread_mutex_unlock(&sched.lock);
+        node_release(node);
+    }
+    free(stack);
+}
@@ -0,0 +1,392 @@
+/*
+ * Sorting
+ * -------
+ * Ordering of operands and directory entries.
+ *
+ * Directory entries are never moved while sorting. sort_file_list() builds
+ * a compact key per entry (mtime, name pointer, entry index), sorts the
+ * keys and stores the resulting permutation in the list; output then walks
+ * the entries through file_list_at(). Each swap moves a 32-byte key
+ * instead of a full file_info_t record.
+ *
+ * Name comparisons start with an 8-byte big-endian prefix of each name,
+ * taken after the prefix shared by the whole list and precomputed into the
+ * key, so most comparisons are a single integer compare and strcmp() only
+ * runs on names that also share those 8 bytes.
+ */
+
+#include "myls.h"
+
+#define TIME_KEY_BYTES 12   // 64-bit seconds + 32-bit nanoseconds
+#define RADIX_SORT_MIN 256  // below this, qsort is faster than the passes
+
+// run by each qsort() comparator; bench/sort_kernels.c counts comparisons
+#ifndef SORT_COUNT_CMP
+#define SORT_COUNT_CMP() ((void)0)
+#endif
+
+static int cmp_file_time(const void *a, const void *b);
+static int cmp_file_lex(const void *a, const void *b);
+static void sort_keys(sort_key_t *keys, int n, bool sort_time);
+
+/*
+ * name_prefix
+ * -----------
+ * Pack the first 8 bytes of a name into a big-endian integer, padding
+ * shorter names with zero bytes.
+ *
+ * Notes:
+ *   - Comparing two prefixes as unsigned integers gives the same result
+ *     as strcmp() on those 8 bytes, since strcmp() compares unsigned
+ *     chars and a terminating NUL sorts below every other byte
+ */
+static inline uint64_t name_prefix(const char *name)
+{
+    uint64_t prefix = 0;
+    int i = 0;
+    for (; i < 8 && name[i]; ++i)
+        prefix = (prefix << 8) | (unsigned char)name[i];
+    return i ? prefix << (8 * (8 - i)) : 0;
+}
+
+/*
+ * common_prefix_len
+ * -----------------
+ * Length of the prefix shared by every name of an array, capped at the
+ * shortest name.
+ *
+ * Parameters:
+ *   names  - first name pointer; subsequent ones are stride bytes apart
+ *   stride - distance in bytes between consecutive name pointers
+ *   count  - number of names
+ */
+static size_t common_prefix_len(const char *const *names, size_t stride, int count)
+{
+    if (count == 0)
+        return 0;
+    const char *first = *names;
+    size_t lcp = strlen(first);
+    for (int i = 1; i < count && lcp > 0; ++i) {
+        const char *name = *(const char *const *)((const char *)names + (size_t)i * stride);
+        size_t j = 0;
+        while (j < lcp && name[j] == first[j])
+            j++;
+        lcp = j;
+    }
+    return lcp;
+}
+
+/*
+ * set_name_keys
+ * -------------
+ * Point each key past the common prefix of all names and pack the next
+ * 8 bytes into its prefix.
+ *
+ * Notes:
+ *   - Bytes shared by every name cannot affect the order, so skipping
+ *     them keeps the packed prefix useful for names such as dated logs
+ *     or build artifacts that all start the same way
+ */
+static void set_name_keys(sort_key_t *keys, int count)
+{
+    size_t lcp = common_prefix_len(&keys[0].name, sizeof(sort_key_t), count);
+    for (int i = 0; i < count; ++i) {
+        keys[i].name += lcp;
+        keys[i].prefix = name_prefix(keys[i].name);
+    }
+}
+
+/*
+ * cmp_name_keys
+ * -------------
+ * Compare two keys by name, in strcmp() order.
+ *
+ * Behavior:
+ *   - Compares the packed prefixes as integers first
+ *   - Equal prefixes whose last byte is NUL mean both names end within
+ *     the prefix, so the names are equal
+ *   - Otherwise both names share their first 8 bytes and strcmp() only
+ *     looks at the remainder
+ */
+static inline int cmp_name_keys(const sort_key_t *a, const sort_key_t *b)
+{
+    if (a->prefix != b->prefix)
+        return a->prefix < b->prefix ? -1 : 1;
+    if ((a->prefix & 0xff) == 0)
+        return 0;
+    return strcmp(a->name + 8, b->name + 8);
+}
+
+/*
+ * sort_operands
+ * -------------
+ * Sort command-line operands by name or, with -t, by modification time.
+ *
+ * Parameters:
+ *   ops       - operands classified by gather_paths()
+ *   count     - number of operands in the array
+ *   sort_time - when true, newest first with names breaking ties
+ *
+ * Behavior:
+ *   - Uses the metadata captured during classification; operands are
+ *     never stat'ed again
+ *   - Sorts keys with sort_keys(), exactly like directory entries, and
+ *     permutes the records once at the end
+ */
+void sort_operands(operand_t *ops, int count, bool sort_time)
+{
+    if (count == 0)
+        return;
+    stats_span_t span;
+    stats_begin(&span);
+    sort_key_t *keys = xmalloc((size_t)count * sizeof(sort_key_t));
+    for (int i = 0; i < count; ++i) {
+        keys[i].sec = ops[i].info.sec;
+        keys[i].nsec = (int32_t)ops[i].info.nsec;
+        keys[i].index = (uint32_t)i;
+        keys[i].name = ops[i].path;
+    }
+    set_name_keys(keys, count);
+    sort_keys(keys, count, sort_time);
+
+    operand_t *sorted = xmalloc((size_t)count * sizeof(operand_t));
+    for (int i = 0; i < count; ++i)
+        sorted[i] = ops[keys[i].index];
+    memcpy(ops, sorted, (size_t)count * sizeof(operand_t));
+    free(sorted);
+    free(keys);
+    stats_end(&span, STATS_SORT, (uint64_t)count, NULL);
+}
+
+/*
+ * build_sort_keys
+ * ---------------
+ * Extract one sort_key_t per entry of a list.
+ *
+ * Notes:
+ *   - Key names skip the prefix common to all entries (see set_name_keys)
+ *     and are only meant for comparisons
+ *
+ * Returns:
+ *   A heap array of flist->count keys; the caller frees it.
+ */
+static sort_key_t* build_sort_keys(const file_list_t *flist)
+{
+    sort_key_t *keys = xmalloc((size_t)flist->count * sizeof(sort_key_t));
+    for (int i = 0; i < flist->count; ++i) {
+        keys[i].sec = flist->files[i].sec;
+        keys[i].nsec = (int32_t)flist->files[i].nsec;
+        keys[i].index = (uint32_t)i;
+        keys[i].name = flist->files[i].name;
+    }
+    set_name_keys(keys, flist->count);
+    return keys;
+}
+
+/*
+ * time_digit
+ * ----------
+ * Extract byte d (0 = least significant) of the 96-bit radix key of an
+ * entry. The key is arranged so that ascending key order is descending
+ * modification time:
+ *
+ *     bits 95..32: ~(sec with its sign bit flipped)
+ *     bits 31..0 : ~nsec
+ */
+static inline unsigned time_digit(const sort_key_t *k, int d)
+{
+    if (d < 4)
+        return (~(uint32_t)k->nsec >> (8 * d)) & 0xff;
+    uint64_t sec = ~((uint64_t)k->sec ^ (UINT64_C(1) << 63));
+    return (sec >> (8 * (d - 4))) & 0xff;
+}
+
+/*
+ * radix_sort_time
+ * ---------------
+ * Sort keys newest first with an LSD radix sort on the packed (sec, nsec)
+ * key, then order equal-time runs by name.
+ *
+ * Parameters:
+ *   keys - keys to sort in place
+ *   n    - number of keys
+ *
+ * Behavior:
+ *   - Counts all twelve byte histograms in a single pass
+ *   - Skips every pass whose byte is identical across all keys, which is
+ *     common for the high bytes of timestamps from one directory
+ *   - Each remaining pass is a stable counting scatter between keys and a
+ *     scratch buffer
+ *   - Names are compared only inside runs of identical timestamps, giving
+ *     the same order as cmp_file_time()
+ */
+static void radix_sort_time(sort_key_t *keys, int n)
+{
+    uint32_t (*counts)[256] = xmalloc(TIME_KEY_BYTES * sizeof(*counts));
+    memset(counts, 0, TIME_KEY_BYTES * sizeof(*counts));
+    for (int i = 0; i < n; ++i)
+        for (int d = 0; d < TIME_KEY_BYTES; ++d)
+            counts[d][time_digit(&keys[i], d)]++;
+
+    sort_key_t *scratch = xmalloc((size_t)n * sizeof(sort_key_t));
+    sort_key_t *src = keys;
+    sort_key_t *dst = scratch;
+
+    for (int d = 0; d < TIME_KEY_BYTES; ++d) {
+        uint32_t *count = counts[d];
+        if (count[time_digit(&src[0], d)] == (uint32_t)n)
+            continue; // every key shares this byte
+
+        uint32_t offset = 0;
+        for (int b = 0; b < 256; ++b) {
+            uint32_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+        for (int i = 0; i < n; ++i)
+            dst[count[time_digit(&src[i], d)]++] = src[i];
+
+        sort_key_t *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    if (src != keys)
+        memcpy(keys, src, (size_t)n * sizeof(sort_key_t));
+    free(scratch);
+    free(counts);
+
+    // break timestamp ties by name, only inside equal-key runs
+    for (int i = 0; i < n; ) {
+        int j = i + 1;
+        while (j < n && keys[j].sec == keys[i].sec && keys[j].nsec == keys[i].nsec)
+            j++;
+        if (j - i > 1)
+            qsort(keys + i, j - i, sizeof(sort_key_t), cmp_file_lex);
+        i = j;
+    }
+}
+
+/*
+ * sort_keys
+ * ---------
+ * Sort prepared keys into display order: newest first for -t (radix sort
+ * once there are at least RADIX_SORT_MIN keys), strcmp() order otherwise.
+ */
+static void sort_keys(sort_key_t *keys, int n, bool sort_time)
+{
+    if (sort_time && n >= RADIX_SORT_MIN)
+        radix_sort_time(keys, n);
+    else if (sort_time)
+        qsort(keys, n, sizeof(sort_key_t), cmp_file_time);
+    else
+        qsort(keys, n, sizeof(sort_key_t), cmp_file_lex);
+}
+
+/*
+ * sort_file_list
+ * --------------
+ * Sort the contents of a file_list_t according to the selected ordering mode.
+ *
+ * Parameters:
+ *   flist     - pointer to a file_list_t containing directory entries
+ *   sort_time - when true, sort entries by modification time (-t);
+ *               otherwise, sort entries lexicographically by name
+ *
+ * Behavior:
+ *   - Builds a compact sort_key_t array and sorts it with sort_keys()
+ *   - Stores the sorted entry indices in flist->order; the records in
+ *     flist->files are left in filesystem order
+ *   - When sort_time is enabled:
+ *       • Orders entries by modification time (newest first)
+ *       • Uses nanosecond precision to break ties
+ *       • Falls back to lexicographical name comparison for stability
+ *   - When sort_time is disabled:
+ *       • Orders entries alphabetically by name
+ *
+ * Notes:
+ *   - Entries must be visited through file_list_at() afterwards
+ *   - Timed as the sort phase of the directory's --stats record
+ */
+void sort_file_list(file_list_t *flist, bool sort_time)
+{
+    stats_span_t span;
+    stats_begin(&span);
+    if (flist->count > 0) {
+        sort_key_t *keys = build_sort_keys(flist);
+        sort_keys(keys, flist->count, sort_time);
+
+        if (!flist->order)
+            stats_store((int64_t)flist->count * (int64_t)sizeof(uint32_t));
+        flist->order = xrealloc(flist->order, (size_t)flist->count * sizeof(uint32_t));
+        for (int i = 0; i < flist->count; ++i)
+            flist->order[i] = keys[i].index;
+        free(keys);
+    }
+    stats_end(&span, STATS_SORT, (uint64_t)flist->count, flist->stats);
+}
+
+/*
+ * cmp_file_time
+ * -------------
+ * Comparator function for time-based ordering of filesystem entries.
+ *
+ * Parameters:
+ *   a, b - pointers to sort_key_t elements being compared
+ *
+ * Returns:
+ *   < 0 if entry b should appear before entry a
+ *   > 0 if entry a should appear before entry b
+ *   = 0 if both entries are considered equal
+ *
+ * Ordering Rules:
+ *   - Entries are ordered by modification time in descending order
+ *     (most recently modified first)
+ *   - Seconds are compared before nanoseconds
+ *   - If modification times are identical, entries are ordered
+ *     lexicographically by name to ensure stable output
+ *
+ * Notes:
+ *   - Intended for use with qsort()
+ *   - Declared static as it is internal to this translation unit
+ */
+static int cmp_file_time(const void *a, const void *b)
+{
+    const sort_key_t *fa = a;
+    const sort_key_t *fb = b;
+    SORT_COUNT_CMP();
+
+    if (fa->sec < fb->sec) return 1;
+    if (fa->sec > fb->sec) return -1;
+
+    if (fa->nsec < fb->nsec) return 1;
+    if (fa->nsec > fb->nsec) return -1;
+
+    return cmp_name_keys(fa, fb); // tie-breaker
+}
+
+
+/*
+ * cmp_file_lex
+ * ------------
+ * Comparator function for lexicographical (alphabetical) ordering of
+ * filesystem entries by name.
+ *
+ * Parameters:
+ *   a, b - pointers to sort_key_t elements being compared
+ *
+ * Returns:
+ *   < 0 if the name of a comes before the name of b
+ *   > 0 if the name of a comes after the name of b
+ *   = 0 if both names are identical
+ *
+ * Notes:
+ *   - Compares packed 8-byte prefixes before falling back to strcmp()
+ *     (see cmp_name_keys); the order is identical to strcmp()
+ *   - Intended for use with qsort()
+ *   - Declared static as it is internal to this translation unit
+ */
+static int cmp_file_lex(const void *a, const void *b)
+{
+    SORT_COUNT_CMP();
+    return cmp_name_keys(a, b);
+}
@@ -0,0 +1,334 @@
+/*
+ * Stat Engines
+ * ------------
+ * Per-entry metadata retrieval for read_directory().
+ *
+ * stat_entry() is the single-entry primitive used by every engine. The
+ * rest of this file is the bounded worker pool used when --jobs N is
+ * given (the io_uring engine lives in uring.c).
+ *
+ * On high-latency filesystems (NFS, FUSE) each stat is a round trip, so
+ * issuing them one at a time leaves the link idle. The pool keeps up to N
+ * stat calls in flight: read_directory() first collects every name of a
+ * directory, then stat_pool_run() hands the batch to the workers, which
+ * claim small chunks of entries from a shared counter and fill in their
+ * metadata. Entries that could not be stat'ed are removed afterwards,
+ * preserving the original order, so the result is identical to the
+ * serial loop.
+ *
+ * The threads are created once per run and reused for every directory,
+ * and for command-line operands (stat_pool_batch(), see operands.c).
+ */
+
+#include "myls.h"
+#include<pthread.h>
+#include<stdatomic.h>
+#include<sys/sysmacros.h>
+
+#define STAT_CHUNK 16
+
+#ifdef STATX_TYPE
+/*
+ * statx_mask
+ * ----------
+ * Translate a STAT_NEED_* mask into the statx() request mask.
+ */
+unsigned statx_mask(unsigned fields){
+    unsigned mask = 0;
+    if(fields & STAT_NEED_TYPE)
+        mask |= STATX_TYPE;
+    if(fields & STAT_NEED_MTIME)
+        mask |= STATX_MTIME;
+    if(fields & STAT_NEED_MODE)
+        mask |= STATX_TYPE | STATX_MODE;
+    if(fields & STAT_NEED_NLINK)
+        mask |= STATX_NLINK;
+    if(fields & STAT_NEED_OWNER)
+        mask |= STATX_UID | STATX_GID;
+    if(fields & STAT_NEED_SIZE)
+        mask |= STATX_SIZE | STATX_BLOCKS;
+    return mask;
+}
+
+/*
+ * statx_fill
+ * ----------
+ * Copy the fields myls uses from a statx() result into an entry record.
+ * Shared by stat_entry() and the io_uring engine.
+ */
+void statx_fill(file_info_t* info, const struct statx* stx){
+    info->sec = stx->stx_mtime.tv_sec;
+    info->nsec = stx->stx_mtime.tv_nsec;
+    info->is_dir = S_ISDIR(stx->stx_mode);
+    info->mode = stx->stx_mode;
+    info->nlink = stx->stx_nlink;
+    info->uid = stx->stx_uid;
+    info->gid = stx->stx_gid;
+    if(S_ISCHR(stx->stx_mode) || S_ISBLK(stx->stx_mode))
+        info->size = makedev(stx->stx_rdev_major, stx->stx_rdev_minor);
+    else
+        info->size = stx->stx_size;
+    info->blocks = stx->stx_blocks;
+}
+#endif
+
+/*
+ * stat_entry
+ * ----------
+ * Retrieve metadata for a single directory entry relative to an open
+ * directory file descriptor.
+ *
+ * Parameters:
+ *   dfd    - file descriptor of the directory containing the entry
+ *   name   - entry name within that directory
+ *   fields - STAT_NEED_* mask of the fields the caller will use, plus
+ *            STAT_FOLLOW to describe the target of a symbolic link
+ *   info   - record receiving sec, nsec, is_dir and the -l fields
+ *
+ * Returns:
+ *   0 on success, -1 if the entry could not be stat'ed.
+ *
+ * Behavior:
+ *   - Uses statx() with AT_SYMLINK_NOFOLLOW on Linux, requesting only the
+ *     fields in the mask
+ *   - Falls back to fstatat() with AT_SYMLINK_NOFOLLOW where statx() is
+ *     unavailable (older kernels, seccomp filters, other systems)
+ *   - AT_SYMLINK_NOFOLLOW is dropped when STAT_FOLLOW is set
+ *
+ * Notes:
+ *   - The kernel resolves only name relative to dfd, so no full path is
+ *     formatted and the parent path is never walked again
+ */
+int stat_entry(int dfd, const char* name, unsigned fields, file_info_t* info){
+    int nofollow = (fields & STAT_FOLLOW) ? 0 : AT_SYMLINK_NOFOLLOW;
+#ifdef STATX_TYPE
+    static volatile bool statx_unavailable = false;
+    if(!statx_unavailable){
+        struct statx stx;
+        uint64_t start = stats_call_begin();
+        int ret = statx(dfd, name, nofollow | AT_NO_AUTOMOUNT, statx_mask(fields), &stx);
+        stats_call_end(STATS_SYS_STATX, start, name);
+        if(!ret){
+            statx_fill(info, &stx);
+            return 0;
+        }
+        if(errno != ENOSYS)
+            return -1;
+        statx_unavailable = true;
+    }
+#else
+    (void)fields;
+#endif
+
+    struct stat st;
+    uint64_t start = stats_call_begin();
+    int ret = fstatat(dfd, name, &st, nofollow);
+    stats_call_end(STATS_SYS_FSTATAT, start, name);
+    if(ret)
+        return -1;
+    info->sec = ST_MTIM(st).tv_sec;
+    info->nsec = ST_MTIM(st).tv_nsec;
+    info->is_dir = S_ISDIR(st.st_mode);
+    info->mode = st.st_mode;
+    info->nlink = (uint32_t)st.st_nlink;
+    info->uid = st.st_uid;
+    info->gid = st.st_gid;
+    info->size = (S_ISCHR(st.st_mode) || S_ISBLK(st.st_mode)) ? (uint64_t)st.st_rdev : (uint64_t)st.st_size;
+    info->blocks = (uint64_t)st.st_blocks;
+    return 0;
+}
+
+static struct{
+    pthread_t* threads;
+    int nthreads;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    pthread_mutex_t run_lock;   // serialises concurrent stat_pool_run() callers
+
+    // current batch
+    unsigned long generation;
+    int busy;                   // workers still processing the batch
+    bool stopping;
+    int dfd;
+    unsigned fields;
+    file_info_t* files;
+    bool* failed;
+    int count;
+    const char* dir;            // stats_dir() of the caller, for --stats
+    atomic_int next;
+}pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work_ready = PTHREAD_COND_INITIALIZER,
+    .work_done = PTHREAD_COND_INITIALIZER,
+    .run_lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/*
+ * stat_batch_work
+ * ---------------
+ * Claim chunks of the current batch and stat them until none remain.
+ * Runs on every worker and on the calling thread.
+ */
+static void stat_batch_work(void){
+    stats_set_dir(pool.dir);
+    uint64_t traced = trace_begin();
+    uint64_t done = 0;
+    for(;;){
+        int start = atomic_fetch_add(&pool.next, STAT_CHUNK);
+        if(start >= pool.count)
+            break;
+        int end = start + STAT_CHUNK < pool.count ? start + STAT_CHUNK : pool.count;
+        for(int i = start; i < end; ++i){
+            file_info_t* info = &pool.files[i];
+            pool.failed[i] = stat_entry(pool.dfd, info->name, pool.fields, info) != 0;
+        }
+        done += (uint64_t)(end - start);
+    }
+    // this thread's share of the batch, for --trace
+    if(done)
+        trace_end("stat work", pool.dir, done, traced);
+}
+
+/*
+ * stat_worker
+ * -----------
+ * Thread body: wait for a new batch generation, work on it, report done.
+ */
+static void* stat_worker(void* arg){
+    (void)arg;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool.lock);
+    for(;;){
+        while(!pool.stopping && pool.generation == seen)
+            pthread_cond_wait(&pool.work_ready, &pool.lock);
+        if(pool.stopping)
+            break;
+        seen = pool.generation;
+        pthread_mutex_unlock(&pool.lock);
+
+        stat_batch_work();
+
+        pthread_mutex_lock(&pool.lock);
+        if(--pool.busy == 0)
+            pthread_cond_signal(&pool.work_done);
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+/*
+ * stat_pool_start
+ * ---------------
+ * Create the worker pool.
+ *
+ * Parameters:
+ *   jobs - total number of concurrent stat calls; the calling thread
+ *          takes part, so jobs - 1 workers are created
+ *
+ * Notes:
+ *   - If thread creation fails, the pool runs with the threads it has
+ *     (possibly none), which degrades to the serial loop
+ */
+void stat_pool_start(int jobs){
+    pool.threads = xmalloc(sizeof(pthread_t) * (size_t)(jobs - 1));
+    pool.nthreads = 0;
+    for(int i = 0; i < jobs - 1; ++i){
+        if(pthread_create(&pool.threads[i], NULL, stat_worker, NULL))
+            break;
+        pool.nthreads++;
+    }
+}
+
+/*
+ * stat_pool_stop
+ * --------------
+ * Stop and join all workers. Safe to call when the pool was never started.
+ */
+void stat_pool_stop(void){
+    pthread_mutex_lock(&pool.lock);
+    pool.stopping = true;
+    pthread_cond_broadcast(&pool.work_ready);
+    pthread_mutex_unlock(&pool.lock);
+
+    for(int i = 0; i < pool.nthreads; ++i)
+        pthread_join(pool.threads[i], NULL);
+    free(pool.threads);
+    pool.threads = NULL;
+    pool.nthreads = 0;
+}
+
+/*
+ * stat_pool_batch
+ * ---------------
+ * Stat an array of records in parallel, reporting failures per record.
+ *
+ * Parameters:
+ *   dfd    - directory file descriptor the names are relative to
+ *            (AT_FDCWD for command-line operands)
+ *   files  - records whose name is set; metadata is filled in place
+ *   count  - number of records
+ *   fields - STAT_NEED_* mask (and STAT_FOLLOW) passed to stat_entry()
+ *   failed - output: failed[i] is set if files[i] could not be stat'ed
+ *
+ * Behavior:
+ *   - Publishes the batch to the workers and joins in on the calling thread
+ *   - Returns only once every record has been processed
+ *   - Without a started pool, the calling thread stats the whole batch
+ */
+void stat_pool_batch(int dfd, file_info_t* files, int count, unsigned fields, bool* failed){
+    if(count == 0)
+        return;
+    uint64_t start = trace_begin();
+
+    pthread_mutex_lock(&pool.run_lock);
+    pthread_mutex_lock(&pool.lock);
+    pool.dfd = dfd;
+    pool.fields = fields;
+    pool.files = files;
+    pool.failed = failed;
+    pool.count = count;
+    pool.dir = stats_dir();
+    atomic_store(&pool.next, 0);
+    pool.busy = pool.nthreads;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.work_ready);
+    pthread_mutex_unlock(&pool.lock);
+
+    stat_batch_work();
+
+    pthread_mutex_lock(&pool.lock);
+    while(pool.busy > 0)
+        pthread_cond_wait(&pool.work_done, &pool.lock);
+    pthread_mutex_unlock(&pool.lock);
+    pthread_mutex_unlock(&pool.run_lock);
+    trace_end("stat batch", stats_dir(), (uint64_t)count, start);
+}
+
+/*
+ * stat_pool_run
+ * -------------
+ * Stat every entry of a list in parallel and drop the ones that fail.
+ *
+ * Parameters:
+ *   dfd    - file descriptor of the directory holding the entries
+ *   flist  - entries collected by read_directory(), names already set
+ *   fields - STAT_NEED_* mask passed through to stat_entry()
+ *
+ * Behavior:
+ *   - Stats the entries with stat_pool_batch()
+ *   - Compacts out entries whose stat failed, keeping the original
+ *     filesystem order, exactly as the serial loop would have skipped them
+ *   - Without a started pool, the calling thread stats the whole batch,
+ *     which makes this the synchronous fallback for other engines
+ */
+void stat_pool_run(int dfd, file_list_t* flist, unsigned fields){
+    if(flist->count == 0)
+        return;
+
+    bool* failed = xmalloc((size_t)flist->count * sizeof(bool));
+    stat_pool_batch(dfd, flist->files, flist->count, fields, failed);
+    file_list_drop_failed(flist, failed);
+    free(failed);
+}
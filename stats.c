@@ -0,0 +1,691 @@
+/*
+ * Run Statistics (--stats)
+ * ------------------------
+ * Phase timings, system call counts and latencies, bytes written and the
+ * entry store's memory high-water mark, reported on standard error at the
+ * end of a run as text or as one JSON document.
+ *
+ * Phases are measured with spans: stats_begin() samples the monotonic
+ * clock and the calling thread's CPU clock, stats_end() adds the
+ * difference to the run totals and, for the per-directory phases, to the
+ * directory's record. A record is created by read_directory(), travels
+ * with its file_list_t through sorting (possibly on another thread) and is
+ * closed by print_entries(); directories are reported in the order they
+ * were printed.
+ *
+ * System calls are bracketed by stats_call_begin() / stats_call_end().
+ * Each thread records their latencies into its own log-bucketed histogram
+ * and keeps its own heap of the slowest calls, so the stat pool, the
+ * read-ahead pipeline and the -R workers never share a cache line per
+ * call; the per-thread data is merged when the report is printed. Phase
+ * totals are relaxed atomics. Without --stats every hook returns after
+ * testing stats_enabled.
+ *
+ * With --trace, spans and directory records are kept even without
+ * --stats, and every closed span is also handed to trace_span(); the
+ * per-call hooks stay off unless --stats is given too.
+ */
+
+#include "myls.h"
+#include<pthread.h>
+#include<stdatomic.h>
+#include<time.h>
+#include<sys/resource.h>
+
+/*
+ * Latency histogram
+ * -----------------
+ * HDR-style buckets: values below 2 * HIST_SUB nanoseconds are exact,
+ * larger ones fall into HIST_SUB linear sub-buckets per power of two, so
+ * any reported percentile is within 1/HIST_SUB (6.25%) of the true value
+ * over the whole 64-bit range, with a fixed 976 buckets per call type.
+ */
+#define HIST_SUB_BITS 4
+#define HIST_SUB      (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS  ((64 - HIST_SUB_BITS + 1) * HIST_SUB)
+
+/*
+ * dir_stats
+ * ---------
+ * Record of one listed directory.
+ *
+ * Fields:
+ *   path        - heap copy of the directory path
+ *   entries     - entries produced by the read phase
+ *   store_bytes - memory held by the directory's file_list_t when printed
+ *   phase       - wall and CPU time per phase (STATS_CLASSIFY is unused)
+ *   seq         - position in output order, 0 until the record is closed
+ *   next        - next record in creation order
+ */
+struct dir_stats{
+    char* path;
+    uint64_t entries;
+    size_t store_bytes;
+    stats_span_t phase[STATS_PHASES];
+    uint64_t seq;
+    struct dir_stats* next;
+};
+
+/*
+ * slow_call_t
+ * -----------
+ * One of the slowest calls seen: latency, call type and the entry or
+ * directory it was made for (heap string).
+ */
+typedef struct{
+    uint64_t ns;
+    int sys;
+    char* path;
+}slow_call_t;
+
+/*
+ * thread_stats_t
+ * --------------
+ * Call statistics of one thread, created on its first recorded call and
+ * kept until the report, after the thread may have exited.
+ *
+ * Fields:
+ *   hist  - latency histogram per call type
+ *   max   - exact maximum latency per call type
+ *   slow  - min-heap on ns of the thread's slowest calls (--stats-slowest),
+ *           grown on demand up to the requested count
+ *   nslow - number of entries in slow
+ *   cap   - capacity of slow
+ *   next  - next thread in the registry
+ */
+typedef struct thread_stats{
+    uint64_t hist[STATS_SYSCALLS][HIST_BUCKETS];
+    uint64_t max[STATS_SYSCALLS];
+    slow_call_t* slow;
+    int nslow;
+    int cap;
+    struct thread_stats* next;
+}thread_stats_t;
+
+static const char* const phase_names[STATS_PHASES] = {
+    "classify", "read", "sort", "output",
+};
+
+static const char* const syscall_names[STATS_SYSCALLS] = {
+    "open", "getdents64", "statx", "fstatat", "io_uring_enter",
+    "io_uring_statx", "readlinkat", "writev",
+};
+
+bool stats_enabled = false;
+
+static struct{
+    char format;                                // 't' text, 'j' JSON
+    int slowest;                                // slowest calls to name
+    stats_span_t start;
+    atomic_uint_fast64_t calls[STATS_PHASES];
+    atomic_uint_fast64_t items[STATS_PHASES];
+    atomic_uint_fast64_t wall[STATS_PHASES];
+    atomic_uint_fast64_t cpu[STATS_PHASES];
+    atomic_uint_fast64_t bytes_written;
+    atomic_int_fast64_t store_live;
+    atomic_int_fast64_t store_peak;
+    pthread_mutex_t lock;                       // guards both registries
+    dir_stats_t* head;
+    thread_stats_t* threads;
+    atomic_uint_fast64_t closed;
+}stats = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static __thread thread_stats_t* tls_stats = NULL;
+static __thread const char* tls_dir = NULL;
+
+static uint64_t clock_ns(clockid_t clock){
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * stats_clock
+ * -----------
+ * Monotonic time in nanoseconds, the time base of all call latencies.
+ */
+uint64_t stats_clock(void){
+    return clock_ns(CLOCK_MONOTONIC);
+}
+
+/*
+ * stats_start
+ * -----------
+ * Enable collection for this run.
+ *
+ * Parameters:
+ *   format  - 't' for the text report, 'j' for JSON
+ *   slowest - number of slowest calls to name in the report (0 for none)
+ */
+void stats_start(char format, int slowest){
+    stats.format = format;
+    stats.slowest = slowest;
+    stats_enabled = true;
+    stats_begin(&stats.start);
+}
+
+/*
+ * stats_begin
+ * -----------
+ * Open a span on the calling thread.
+ */
+void stats_begin(stats_span_t* span){
+    if(!stats_enabled && !trace_enabled)
+        return;
+    span->wall = clock_ns(CLOCK_MONOTONIC);
+    span->cpu = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+}
+
+/*
+ * stats_end
+ * ---------
+ * Close a span opened by stats_begin() on the same thread.
+ *
+ * Parameters:
+ *   span  - the open span
+ *   phase - phase the span belongs to
+ *   items - operands or entries handled by the span
+ *   dir   - directory record to charge as well, or NULL
+ *
+ * Notes:
+ *   - CPU time is the calling thread's; work done by stat pool workers
+ *     on its behalf only shows in the run's process CPU time
+ *   - With --trace, the span is recorded as a trace event named after the
+ *     phase, with the directory as its detail
+ */
+void stats_end(const stats_span_t* span, int phase, uint64_t items, dir_stats_t* dir){
+    if(!stats_enabled && !trace_enabled)
+        return;
+    if(trace_enabled)
+        trace_span(phase_names[phase], dir ? dir->path : NULL, items, span->wall);
+    if(!stats_enabled)
+        return;
+    uint64_t wall = clock_ns(CLOCK_MONOTONIC) - span->wall;
+    uint64_t cpu = clock_ns(CLOCK_THREAD_CPUTIME_ID) - span->cpu;
+    atomic_fetch_add_explicit(&stats.calls[phase], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats.items[phase], items, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats.wall[phase], wall, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats.cpu[phase], cpu, memory_order_relaxed);
+    if(dir){
+        dir->phase[phase].wall += wall;
+        dir->phase[phase].cpu += cpu;
+        if(phase == STATS_READ)
+            dir->entries += items;
+    }
+}
+
+/*
+ * stats_set_dir / stats_dir
+ * -------------------------
+ * Directory the calling thread is working on, used to name the entries of
+ * slow calls. Set by the readers and the printer, and handed on to stat
+ * pool workers with each batch; NULL for command-line operands.
+ */
+void stats_set_dir(const char* dir){
+    tls_dir = dir;
+}
+
+const char* stats_dir(void){
+    return tls_dir;
+}
+
+static int hist_bucket(uint64_t ns){
+    if(ns < HIST_SUB)
+        return (int)ns;
+    int msb = 63 - __builtin_clzll(ns);
+    return (msb - HIST_SUB_BITS + 1) * HIST_SUB +
+           (int)((ns >> (msb - HIST_SUB_BITS)) & (HIST_SUB - 1));
+}
+
+// largest value that falls into bucket b
+static uint64_t hist_upper(int b){
+    if(b < 2 * HIST_SUB)
+        return (uint64_t)b;
+    int shift = b / HIST_SUB - 1;
+    uint64_t low = (uint64_t)(HIST_SUB + b % HIST_SUB) << shift;
+    return low + (((uint64_t)1 << shift) - 1);
+}
+
+static thread_stats_t* thread_stats(void){
+    thread_stats_t* t = xmalloc(sizeof(*t));
+    memset(t, 0, sizeof(*t));
+    pthread_mutex_lock(&stats.lock);
+    t->next = stats.threads;
+    stats.threads = t;
+    pthread_mutex_unlock(&stats.lock);
+    tls_stats = t;
+    return t;
+}
+
+/*
+ * call_path
+ * ---------
+ * Name of the object of a call: name inside the thread's directory, the
+ * directory itself when name is NULL, or name alone outside directories.
+ */
+static char* call_path(const char* name){
+    const char* dir = tls_dir;
+    if(!name){
+        name = dir ? dir : "";
+        dir = NULL;
+    }
+    size_t dlen = dir ? strlen(dir) : 0;
+    size_t nlen = strlen(name);
+    bool slash = dlen > 0 && dir[dlen - 1] != '/';
+    char* path = xmalloc(dlen + slash + nlen + 1);
+    if(dlen)
+        memcpy(path, dir, dlen);
+    if(slash)
+        path[dlen] = '/';
+    memcpy(path + dlen + slash, name, nlen + 1);
+    return path;
+}
+
+static void slow_sift_down(slow_call_t* heap, int n, int i){
+    for(;;){
+        int l = 2 * i + 1, r = l + 1, low = i;
+        if(l < n && heap[l].ns < heap[low].ns)
+            low = l;
+        if(r < n && heap[r].ns < heap[low].ns)
+            low = r;
+        if(low == i)
+            return;
+        slow_call_t tmp = heap[i];
+        heap[i] = heap[low];
+        heap[low] = tmp;
+        i = low;
+    }
+}
+
+/*
+ * note_slow
+ * ---------
+ * Offer a call to the thread's heap of slowest calls. Calls faster than
+ * the heap root are rejected with one comparison and no allocation.
+ */
+static void note_slow(thread_stats_t* t, int sys, uint64_t ns, const char* name){
+    int n = t->nslow;
+    if(n == stats.slowest){
+        if(ns <= t->slow[0].ns)
+            return;
+        free(t->slow[0].path);
+        t->slow[0] = (slow_call_t){ns, sys, call_path(name)};
+        slow_sift_down(t->slow, n, 0);
+        return;
+    }
+    if(n == t->cap){
+        t->cap = t->cap > stats.slowest / 2 ? stats.slowest : (t->cap ? t->cap * 2 : 16);
+        t->slow = xrealloc(t->slow, (size_t)t->cap * sizeof(slow_call_t));
+    }
+    // sift the new entry up
+    int i = n;
+    while(i > 0 && t->slow[(i - 1) / 2].ns > ns){
+        t->slow[i] = t->slow[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    t->slow[i] = (slow_call_t){ns, sys, call_path(name)};
+    t->nslow = n + 1;
+}
+
+/*
+ * stats_record_call
+ * -----------------
+ * Record one call that started at start (stats_clock() time).
+ *
+ * Parameters:
+ *   sys   - STATS_SYS_* call type
+ *   start - stats_clock() value taken before the call
+ *   name  - entry the call was made for, relative to stats_dir();
+ *           NULL if the call concerns that directory itself
+ *
+ * Notes:
+ *   - io_uring_enter and writev calls are not tied to one entry and are
+ *     left out of the slowest-call list
+ */
+void stats_record_call(int sys, uint64_t start, const char* name){
+    uint64_t ns = stats_clock() - start;
+    thread_stats_t* t = tls_stats ? tls_stats : thread_stats();
+    t->hist[sys][hist_bucket(ns)]++;
+    if(ns > t->max[sys])
+        t->max[sys] = ns;
+    if(stats.slowest && sys != STATS_SYS_URING_ENTER && sys != STATS_SYS_WRITE)
+        note_slow(t, sys, ns, name);
+}
+
+/*
+ * stats_written
+ * -------------
+ * Count bytes accepted by the kernel for standard output.
+ */
+void stats_written(uint64_t bytes){
+    if(stats_enabled)
+        atomic_fetch_add_explicit(&stats.bytes_written, bytes, memory_order_relaxed);
+}
+
+/*
+ * stats_store
+ * -----------
+ * Track memory held by entry stores: delta bytes were allocated (> 0) or
+ * released (< 0). The high-water mark covers all lists alive at once,
+ * e.g. directories waiting in the read-ahead buffer.
+ */
+void stats_store(int64_t delta){
+    if(!stats_enabled)
+        return;
+    int64_t live = atomic_fetch_add_explicit(&stats.store_live, delta, memory_order_relaxed) + delta;
+    int64_t peak = atomic_load_explicit(&stats.store_peak, memory_order_relaxed);
+    while(live > peak &&
+          !atomic_compare_exchange_weak_explicit(&stats.store_peak, &peak, live,
+                                                 memory_order_relaxed, memory_order_relaxed))
+        ;
+}
+
+/*
+ * stats_dir_open
+ * --------------
+ * Create the record of a directory about to be read.
+ *
+ * Returns:
+ *   The record, or NULL without --stats and --trace. Records are owned by this
+ *   module and released by stats_report(), so a list that is never
+ *   printed does not leak its record.
+ */
+dir_stats_t* stats_dir_open(const char* path){
+    if(!stats_enabled && !trace_enabled)
+        return NULL;
+    dir_stats_t* dir = xmalloc(sizeof(*dir));
+    memset(dir, 0, sizeof(*dir));
+    size_t len = strlen(path);
+    dir->path = xmalloc(len + 1);
+    memcpy(dir->path, path, len + 1);
+    pthread_mutex_lock(&stats.lock);
+    dir->next = stats.head;
+    stats.head = dir;
+    pthread_mutex_unlock(&stats.lock);
+    return dir;
+}
+
+/*
+ * stats_dir_close
+ * ---------------
+ * Mark a directory record as printed, fixing its place in the report.
+ *
+ * Parameters:
+ *   dir         - record from stats_dir_open(), or NULL
+ *   store_bytes - memory held by the directory's entries (0 if streamed)
+ */
+void stats_dir_close(dir_stats_t* dir, size_t store_bytes){
+    if(!dir)
+        return;
+    dir->store_bytes = store_bytes;
+    dir->seq = atomic_fetch_add_explicit(&stats.closed, 1, memory_order_relaxed) + 1;
+}
+
+/*
+ * call_summary_t / report_t
+ * -------------------------
+ * Data of the final report: per-thread call statistics merged, printed
+ * directories in output order and the process resource usage.
+ */
+typedef struct{
+    uint64_t count;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t max;
+}call_summary_t;
+
+typedef struct{
+    dir_stats_t** dirs;
+    int ndirs;
+    uint64_t elapsed;
+    struct rusage ru;
+    call_summary_t calls[STATS_SYSCALLS];
+    slow_call_t* slow;
+    int nslow;
+}report_t;
+
+static int cmp_seq(const void* a, const void* b){
+    uint64_t x = (*(dir_stats_t* const*)a)->seq, y = (*(dir_stats_t* const*)b)->seq;
+    return x < y ? -1 : (x > y);
+}
+
+static int cmp_slow(const void* a, const void* b){
+    uint64_t x = ((const slow_call_t*)a)->ns, y = ((const slow_call_t*)b)->ns;
+    return x > y ? -1 : (x < y);
+}
+
+// smallest bucket bound with at least q of the calls at or below it
+static uint64_t percentile(const uint64_t* hist, uint64_t count, uint64_t max, double q){
+    uint64_t rank = (uint64_t)(q * (double)count + 0.999999);
+    uint64_t seen = 0;
+    for(int b = 0; b < HIST_BUCKETS; ++b){
+        seen += hist[b];
+        if(seen >= rank && seen > 0){
+            uint64_t v = hist_upper(b);
+            return v < max ? v : max;
+        }
+    }
+    return max;
+}
+
+/*
+ * summarize_calls
+ * ---------------
+ * Merge the per-thread histograms and slowest-call heaps into report.
+ */
+static void summarize_calls(report_t* report){
+    uint64_t* hist = xmalloc(HIST_BUCKETS * sizeof(uint64_t));
+    for(int s = 0; s < STATS_SYSCALLS; ++s){
+        call_summary_t* c = &report->calls[s];
+        memset(hist, 0, HIST_BUCKETS * sizeof(uint64_t));
+        memset(c, 0, sizeof(*c));
+        for(thread_stats_t* t = stats.threads; t; t = t->next){
+            for(int b = 0; b < HIST_BUCKETS; ++b){
+                hist[b] += t->hist[s][b];
+                c->count += t->hist[s][b];
+            }
+            if(t->max[s] > c->max)
+                c->max = t->max[s];
+        }
+        c->p50 = percentile(hist, c->count, c->max, 0.50);
+        c->p90 = percentile(hist, c->count, c->max, 0.90);
+        c->p99 = percentile(hist, c->count, c->max, 0.99);
+    }
+    free(hist);
+
+    int total = 0;
+    for(thread_stats_t* t = stats.threads; t; t = t->next)
+        total += t->nslow;
+    report->slow = xmalloc((size_t)(total ? total : 1) * sizeof(slow_call_t));
+    report->nslow = 0;
+    for(thread_stats_t* t = stats.threads; t; t = t->next)
+        for(int i = 0; i < t->nslow; ++i)
+            report->slow[report->nslow++] = t->slow[i];
+    qsort(report->slow, (size_t)report->nslow, sizeof(slow_call_t), cmp_slow);
+    if(report->nslow > stats.slowest)
+        report->nslow = stats.slowest;
+}
+
+static uint64_t load(atomic_uint_fast64_t* counter){
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+static double ms(uint64_t ns){
+    return (double)ns / 1e6;
+}
+
+static double us(uint64_t ns){
+    return (double)ns / 1e3;
+}
+
+static uint64_t timeval_ns(struct timeval tv){
+    return (uint64_t)tv.tv_sec * 1000000000u + (uint64_t)tv.tv_usec * 1000u;
+}
+
+/*
+ * json_string
+ * -----------
+ * Write s as a JSON string: quotes, backslashes and control bytes are
+ * escaped, other bytes are copied. Shared with the trace writer.
+ */
+void json_string(FILE* f, const char* s){
+    fputc('"', f);
+    for(; *s; ++s){
+        unsigned char c = (unsigned char)*s;
+        if(c == '"' || c == '\\')
+            fprintf(f, "\\%c", c);
+        else if(c < 0x20)
+            fprintf(f, "\\u%04x", c);
+        else
+            fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+static void report_text(FILE* f, const report_t* r){
+    for(int i = 0; i < r->ndirs; ++i){
+        const dir_stats_t* d = r->dirs[i];
+        fprintf(f, "myls: stats: dir %s: %llu entries, %zu store bytes",
+                d->path, (unsigned long long)d->entries, d->store_bytes);
+        for(int p = STATS_READ; p < STATS_PHASES; ++p)
+            fprintf(f, ", %s %.3f/%.3f ms", phase_names[p],
+                    ms(d->phase[p].wall), ms(d->phase[p].cpu));
+        fputc('\n', f);
+    }
+
+    fprintf(f, "myls: stats: %-14s %10s %12s %12s %12s\n", "phase", "calls", "items", "wall ms", "cpu ms");
+    for(int p = 0; p < STATS_PHASES; ++p)
+        fprintf(f, "myls: stats: %-14s %10llu %12llu %12.3f %12.3f\n", phase_names[p],
+                (unsigned long long)load(&stats.calls[p]), (unsigned long long)load(&stats.items[p]),
+                ms(load(&stats.wall[p])), ms(load(&stats.cpu[p])));
+
+    fprintf(f, "myls: stats: %-14s %10s %12s %12s %12s %12s\n",
+            "call", "count", "p50 us", "p90 us", "p99 us", "max us");
+    for(int s = 0; s < STATS_SYSCALLS; ++s){
+        const call_summary_t* c = &r->calls[s];
+        if(c->count)
+            fprintf(f, "myls: stats: %-14s %10llu %12.2f %12.2f %12.2f %12.2f\n", syscall_names[s],
+                    (unsigned long long)c->count, us(c->p50), us(c->p90), us(c->p99), us(c->max));
+    }
+    for(int i = 0; i < r->nslow; ++i)
+        fprintf(f, "myls: stats: slow %d: %s %.2f us %s\n", i + 1,
+                syscall_names[r->slow[i].sys], us(r->slow[i].ns), r->slow[i].path);
+
+    fprintf(f, "myls: stats: bytes written %llu, peak store %lld bytes, max rss %ld KiB\n",
+            (unsigned long long)load(&stats.bytes_written),
+            (long long)atomic_load(&stats.store_peak), r->ru.ru_maxrss);
+    fprintf(f, "myls: stats: elapsed %.3f ms, user %.3f ms, sys %.3f ms\n", ms(r->elapsed),
+            ms(timeval_ns(r->ru.ru_utime)), ms(timeval_ns(r->ru.ru_stime)));
+}
+
+static void report_json(FILE* f, const report_t* r){
+    fprintf(f, "{\"elapsed_ns\":%llu,\"user_ns\":%llu,\"sys_ns\":%llu,\"max_rss_kib\":%ld,",
+            (unsigned long long)r->elapsed, (unsigned long long)timeval_ns(r->ru.ru_utime),
+            (unsigned long long)timeval_ns(r->ru.ru_stime), r->ru.ru_maxrss);
+    fprintf(f, "\"bytes_written\":%llu,\"peak_store_bytes\":%lld,\"phases\":{",
+            (unsigned long long)load(&stats.bytes_written), (long long)atomic_load(&stats.store_peak));
+    for(int p = 0; p < STATS_PHASES; ++p)
+        fprintf(f, "%s\"%s\":{\"calls\":%llu,\"items\":%llu,\"wall_ns\":%llu,\"cpu_ns\":%llu}",
+                p ? "," : "", phase_names[p],
+                (unsigned long long)load(&stats.calls[p]), (unsigned long long)load(&stats.items[p]),
+                (unsigned long long)load(&stats.wall[p]), (unsigned long long)load(&stats.cpu[p]));
+    fprintf(f, "},\"syscalls\":{");
+    for(int s = 0; s < STATS_SYSCALLS; ++s){
+        const call_summary_t* c = &r->calls[s];
+        fprintf(f, "%s\"%s\":{\"count\":%llu,\"p50_ns\":%llu,\"p90_ns\":%llu,\"p99_ns\":%llu,\"max_ns\":%llu}",
+                s ? "," : "", syscall_names[s], (unsigned long long)c->count,
+                (unsigned long long)c->p50, (unsigned long long)c->p90,
+                (unsigned long long)c->p99, (unsigned long long)c->max);
+    }
+    fprintf(f, "},\"slowest\":[");
+    for(int i = 0; i < r->nslow; ++i){
+        fprintf(f, "%s{\"call\":\"%s\",\"ns\":%llu,\"path\":", i ? "," : "",
+                syscall_names[r->slow[i].sys], (unsigned long long)r->slow[i].ns);
+        json_string(f, r->slow[i].path);
+        fputc('}', f);
+    }
+    fprintf(f, "],\"directories\":[");
+    for(int i = 0; i < r->ndirs; ++i){
+        const dir_stats_t* d = r->dirs[i];
+        fprintf(f, "%s{\"path\":", i ? "," : "");
+        json_string(f, d->path);
+        fprintf(f, ",\"entries\":%llu,\"store_bytes\":%zu",
+                (unsigned long long)d->entries, d->store_bytes);
+        for(int p = STATS_READ; p < STATS_PHASES; ++p)
+            fprintf(f, ",\"%s\":{\"wall_ns\":%llu,\"cpu_ns\":%llu}", phase_names[p],
+                    (unsigned long long)d->phase[p].wall, (unsigned long long)d->phase[p].cpu);
+        fputc('}', f);
+    }
+    fprintf(f, "]}\n");
+}
+
+static void release_records(void){
+    dir_stats_t* d = stats.head;
+    while(d){
+        dir_stats_t* next = d->next;
+        free(d->path);
+        free(d);
+        d = next;
+    }
+    stats.head = NULL;
+}
+
+/*
+ * stats_report
+ * ------------
+ * Print the report on standard error (--stats) and release all records.
+ * Called after the final out_flush() and after every worker thread has
+ * been joined, so every call and write is accounted for.
+ *
+ * Behavior:
+ *   - Text: one line per directory in output order, the phase table,
+ *     call counts with p50 / p90 / p99 / max latency, the slowest calls
+ *     (--stats-slowest), memory and elapsed / CPU time
+ *   - JSON: the same data as a single object on one line
+ *   - Phase times are summed over threads, so with parallel readers
+ *     they can exceed the elapsed time
+ *   - Percentiles are bucket upper bounds, at most 6.25% above the
+ *     true value and never above the exact maximum
+ */
+void stats_report(void){
+    if(!stats_enabled){
+        release_records();
+        return;
+    }
+    report_t report;
+    report.elapsed = clock_ns(CLOCK_MONOTONIC) - stats.start.wall;
+    getrusage(RUSAGE_SELF, &report.ru);
+
+    // printed directories, in output order
+    int ndirs = 0;
+    for(dir_stats_t* d = stats.head; d; d = d->next)
+        ndirs += d->seq != 0;
+    report.dirs = xmalloc((size_t)(ndirs ? ndirs : 1) * sizeof(dir_stats_t*));
+    report.ndirs = 0;
+    for(dir_stats_t* d = stats.head; d; d = d->next)
+        if(d->seq)
+            report.dirs[report.ndirs++] = d;
+    qsort(report.dirs, (size_t)report.ndirs, sizeof(dir_stats_t*), cmp_seq);
+    summarize_calls(&report);
+
+    if(stats.format == 'j')
+        report_json(stderr, &report);
+    else
+        report_text(stderr, &report);
+    free(report.dirs);
+    free(report.slow);
+
+    release_records();
+    thread_stats_t* t = stats.threads;
+    while(t){
+        thread_stats_t* next = t->next;
+        for(int i = 0; i < t->nslow; ++i)
+            free(t->slow[i].path);
+        free(t->slow);
+        free(t);
+        t = next;
+    }
+    stats.threads = NULL;
+    tls_stats = NULL;
+}
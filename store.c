@@ -0,0 +1,229 @@
+/*
+ * Entry Store
+ * -----------
+ * Dynamic storage for directory entries collected by read_directory().
+ *
+ * Entries live in a geometrically grown array of file_info_t records and
+ * their names live in a chunked, length-prefixed string arena. Memory use
+ * therefore scales with the number of entries and the real length of their
+ * names, and no directory is ever truncated.
+ */
+
+#include "myls.h"
+
+/*
+ * xmalloc / xrealloc
+ * ------------------
+ * Allocation wrappers that terminate the program when memory is exhausted.
+ *
+ * Notes:
+ *   - A listing cannot be produced correctly with missing entries, so
+ *     allocation failure is treated as fatal rather than silently
+ *     dropping data
+ */
+void* xmalloc(size_t size){
+    void* ptr = malloc(size);
+    if(!ptr && size){
+        fprintf(stderr, "myls: out of memory\n");
+        exit(1);
+    }
+    return ptr;
+}
+
+void* xrealloc(void* ptr, size_t size){
+    void* grown = realloc(ptr, size);
+    if(!grown && size){
+        fprintf(stderr, "myls: out of memory\n");
+        exit(1);
+    }
+    return grown;
+}
+
+/*
+ * arena_store
+ * -----------
+ * Copy a name into the arena and return a pointer to its first character.
+ *
+ * Parameters:
+ *   arena - arena receiving the name
+ *   name  - bytes of the name (need not be null-terminated)
+ *   len   - number of bytes in name
+ *
+ * Returns:
+ *   Pointer to the null-terminated copy, immediately preceded by its
+ *   uint32_t length prefix.
+ *
+ * Behavior:
+ *   - Allocates a new chunk when the current one cannot hold the record
+ *   - Chunk sizes double from ARENA_FIRST_CHUNK up to ARENA_CHUNK_SIZE, so
+ *     small directories do not each hold a full 64 KB chunk while many
+ *     lists are alive (-R, read-ahead)
+ *   - Oversized names receive a dedicated chunk large enough to fit them
+ */
+static const char* arena_store(name_arena_t* arena, const char* name, size_t len){
+    size_t need = sizeof(uint32_t) + len + 1;
+    arena_chunk_t* chunk = arena->head;
+
+    if(!chunk || chunk->cap - chunk->used < need){
+        size_t cap = chunk ? chunk->cap * 2 : ARENA_FIRST_CHUNK;
+        if(cap > ARENA_CHUNK_SIZE)
+            cap = ARENA_CHUNK_SIZE;
+        if(cap < need)
+            cap = need;
+        chunk = xmalloc(sizeof(arena_chunk_t) + cap);
+        chunk->next = arena->head;
+        chunk->used = 0;
+        chunk->cap = cap;
+        arena->head = chunk;
+        arena->bytes += cap;
+        stats_store((int64_t)cap);
+    }
+
+    char* rec = chunk->data + chunk->used;
+    uint32_t len32 = (uint32_t)len;
+    memcpy(rec, &len32, sizeof(len32));
+    memcpy(rec + sizeof(len32), name, len);
+    rec[sizeof(len32) + len] = '\0';
+    chunk->used += need;
+    return rec + sizeof(len32);
+}
+
+/*
+ * name_width
+ * ----------
+ * Display width of a name in terminal columns, used by the -C / -x
+ * layout: one column per UTF-8 character (continuation bytes are not
+ * counted), saturating at UINT16_MAX.
+ */
+uint16_t name_width(const char* name, size_t len){
+    size_t width = 0;
+    for(size_t i = 0; i < len; ++i)
+        width += ((unsigned char)name[i] & 0xC0) != 0x80;
+    return width > UINT16_MAX ? UINT16_MAX : (uint16_t)width;
+}
+
+/*
+ * file_list_bytes
+ * ---------------
+ * Memory held by a list: arena chunks, the record array and the sort
+ * permutation. This is what --stats reports as entry-store memory.
+ */
+size_t file_list_bytes(const file_list_t* flist){
+    return flist->names.bytes + (size_t)flist->capacity * sizeof(file_info_t) +
+           (flist->order ? (size_t)flist->count * sizeof(uint32_t) : 0);
+}
+
+/*
+ * file_list_init
+ * --------------
+ * Initialise an empty file_list_t. No memory is allocated until the
+ * first entry is added.
+ */
+void file_list_init(file_list_t* flist){
+    flist->files = NULL;
+    flist->count = 0;
+    flist->capacity = 0;
+    flist->names.head = NULL;
+    flist->names.bytes = 0;
+    flist->order = NULL;
+    flist->stats = NULL;
+}
+
+/*
+ * file_list_add
+ * -------------
+ * Append a new entry to the list.
+ *
+ * Parameters:
+ *   flist - list receiving the entry
+ *   name  - entry name bytes (need not be null-terminated)
+ *   len   - length of name in bytes
+ *
+ * Returns:
+ *   Pointer to the new, zero-initialised record with its name set.
+ *   The pointer is valid until the next call to file_list_add().
+ *
+ * Behavior:
+ *   - Doubles the record array when it is full
+ *   - Copies the name into the list's arena and records its display
+ *     width, so column layout never measures names again
+ */
+file_info_t* file_list_add(file_list_t* flist, const char* name, size_t len){
+    if(flist->count == flist->capacity){
+        int cap = flist->capacity ? flist->capacity * 2 : FILE_LIST_INITIAL_CAPACITY;
+        flist->files = xrealloc(flist->files, (size_t)cap * sizeof(file_info_t));
+        stats_store((int64_t)(cap - flist->capacity) * (int64_t)sizeof(file_info_t));
+        flist->capacity = cap;
+    }
+
+    file_info_t* info = &flist->files[flist->count++];
+    memset(info, 0, sizeof(*info));
+    info->name = arena_store(&flist->names, name, len);
+    info->width = name_width(name, len);
+    return info;
+}
+
+/*
+ * file_list_free
+ * --------------
+ * Release the record array and every arena chunk owned by the list,
+ * leaving it in the empty state produced by file_list_init().
+ */
+void file_list_free(file_list_t* flist){
+    stats_store(-(int64_t)file_list_bytes(flist));
+    arena_chunk_t* chunk = flist->names.head;
+    while(chunk){
+        arena_chunk_t* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(flist->files);
+    free(flist->order);
+    file_list_init(flist);
+}
+
+/*
+ * file_list_detach_names
+ * ----------------------
+ * Give every entry a fresh copy of its name and return the chunks that
+ * held the old copies; the caller owns them from then on.
+ *
+ * Notes:
+ *   - Used when the kernel may still read the old copies (io_uring
+ *     requests left in flight by a failed batch), so they must outlive
+ *     the list
+ */
+arena_chunk_t* file_list_detach_names(file_list_t* flist){
+    arena_chunk_t* old = flist->names.head;
+    stats_store(-(int64_t)flist->names.bytes);
+    flist->names.head = NULL;
+    flist->names.bytes = 0;
+    for(int i = 0; i < flist->count; ++i){
+        const char* name = flist->files[i].name;
+        flist->files[i].name = arena_store(&flist->names, name, entry_name_len(name));
+    }
+    return old;
+}
+
+/*
+ * file_list_drop_failed
+ * ---------------------
+ * Remove the entries flagged in failed, keeping the remaining entries in
+ * their original order. Must be called before the list is sorted.
+ *
+ * Parameters:
+ *   flist  - list to compact
+ *   failed - one flag per entry; true marks an entry to remove
+ *
+ * Notes:
+ *   - Used by the batched stat engines so that entries which could not be
+ *     stat'ed are skipped exactly as the serial loop skips them
+ *   - Names of dropped entries stay in the arena until file_list_free()
+ */
+void file_list_drop_failed(file_list_t* flist, const bool* failed){
+    int kept = 0;
+    for(int i = 0; i < flist->count; ++i)
+        if(!failed[i])
+            flist->files[kept++] = flist->files[i];
+    flist->count = kept;
+}
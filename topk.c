@@ -0,0 +1,192 @@
+/*
+ * Top-K Selection (--head N / --tail N)
+ * -------------------------------------
+ * Bounded selection of the first or last N entries of a directory in
+ * display order, used by read_directory() when a limit is given.
+ *
+ * Entries are compared as they are read against a heap of the N best
+ * candidates so far; the heap root is the candidate that would be dropped
+ * next. Most entries lose against the root and are never copied, so a
+ * directory of n entries costs O(n log N) time and O(N) memory instead of
+ * collecting and sorting all n entries.
+ *
+ * Display order is the same as sort_file_list() produces: newest first
+ * for -t, strcmp() order otherwise, and directory order for -U.
+ */
+
+#include "myls.h"
+
+/*
+ * topk_entry_t
+ * ------------
+ * Heap candidate.
+ *
+ * Fields:
+ *   info - metadata; info.name is a heap copy owned by the candidate
+ *   seq  - position in directory order (the display key for -U)
+ */
+typedef struct{
+    file_info_t info;
+    uint64_t seq;
+}topk_entry_t;
+
+/*
+ * display_cmp
+ * -----------
+ * Compare two candidates in display order.
+ *
+ * Returns:
+ *   < 0 if a is displayed before b, > 0 if after, 0 if equivalent.
+ */
+static int display_cmp(const topk_entry_t* a, const topk_entry_t* b, const options_t* opts){
+    if(opts->unsorted)
+        return a->seq < b->seq ? -1 : (a->seq > b->seq);
+    if(opts->sort_time){
+        if(a->info.sec != b->info.sec)
+            return a->info.sec > b->info.sec ? -1 : 1;
+        if(a->info.nsec != b->info.nsec)
+            return a->info.nsec > b->info.nsec ? -1 : 1;
+    }
+    return strcmp(a->info.name, b->info.name);
+}
+
+/*
+ * worse
+ * -----
+ * True if a is further from the kept end than b: later in display order
+ * for --head, earlier for --tail. The heap keeps the worst at the root.
+ */
+static inline bool worse(const topk_entry_t* a, const topk_entry_t* b, const options_t* opts){
+    int c = display_cmp(a, b, opts);
+    return opts->limit_tail ? c < 0 : c > 0;
+}
+
+static void sift_down(topk_entry_t* heap, int n, int i, const options_t* opts){
+    for(;;){
+        int l = 2 * i + 1, r = l + 1, top = i;
+        if(l < n && worse(&heap[l], &heap[top], opts))
+            top = l;
+        if(r < n && worse(&heap[r], &heap[top], opts))
+            top = r;
+        if(top == i)
+            return;
+        topk_entry_t tmp = heap[i];
+        heap[i] = heap[top];
+        heap[top] = tmp;
+        i = top;
+    }
+}
+
+static void sift_up(topk_entry_t* heap, int i, const options_t* opts){
+    while(i > 0){
+        int parent = (i - 1) / 2;
+        if(!worse(&heap[i], &heap[parent], opts))
+            return;
+        topk_entry_t tmp = heap[i];
+        heap[i] = heap[parent];
+        heap[parent] = tmp;
+        i = parent;
+    }
+}
+
+static char* copy_name(const char* name, size_t len){
+    char* copy = xmalloc(len + 1);
+    memcpy(copy, name, len + 1);
+    return copy;
+}
+
+/*
+ * read_directory_topk
+ * -------------------
+ * Read a directory keeping only the first (--head) or last (--tail)
+ * opts->limit entries in display order.
+ *
+ * Parameters:
+ *   path - directory to read
+ *   opts - parsed options (-a, -t, -U, limit and limit_tail are used)
+ *
+ * Returns:
+ *   A file_list_t holding at most opts->limit entries, already in display
+ *   order (sort_file_list() on it is a no-op reordering). An empty list
+ *   is returned if the directory cannot be opened.
+ *
+ * Behavior:
+ *   - Stats an entry only when -t needs its mtime (or d_type is unknown)
+ *   - Compares each candidate against the heap root before copying its
+ *     name, so rejected entries cost one comparison and no allocation
+ *   - Drains the heap worst-first to lay the survivors out in order
+ */
+file_list_t read_directory_topk(const char* path, const options_t* opts){
+    file_list_t flist;
+    file_list_init(&flist);
+    bool want_stat = needs_metadata(opts);
+    unsigned fields = stat_fields(opts);
+    int limit = opts->limit;
+
+    dir_reader_t dir;
+    if(dir_reader_open(&dir, path, 0)){
+        fprintf(stderr, "myls: cannot access %s\n", path);
+        return flist;
+    }
+
+    // grown on demand: N may be far larger than the directory
+    int cap = limit < FILE_LIST_INITIAL_CAPACITY ? limit : FILE_LIST_INITIAL_CAPACITY;
+    topk_entry_t* heap = xmalloc((size_t)cap * sizeof(topk_entry_t));
+    int n = 0;
+    uint64_t seq = 0;
+
+    dir_entry_t entry;
+    while(dir_reader_next(&dir, &entry) > 0){
+        if(!opts->show_all && entry.name[0] == '.')
+            continue;
+
+        topk_entry_t cand;
+        memset(&cand, 0, sizeof(cand));
+        cand.seq = seq++;
+        cand.info.name = entry.name;
+        if(want_stat || entry.type == DT_UNKNOWN){
+            if(stat_entry(dir.fd, entry.name, fields, &cand.info))
+                continue;
+        }
+        else
+            cand.info.is_dir = entry.type == DT_DIR;
+
+        if(n < limit){
+            if(n == cap){
+                cap = cap > limit / 2 ? limit : cap * 2;
+                heap = xrealloc(heap, (size_t)cap * sizeof(topk_entry_t));
+            }
+            cand.info.name = copy_name(entry.name, entry.len);
+            heap[n] = cand;
+            sift_up(heap, n++, opts);
+        }
+        else if(worse(&heap[0], &cand, opts)){
+            free((char*)heap[0].info.name);
+            cand.info.name = copy_name(entry.name, entry.len);
+            heap[0] = cand;
+            sift_down(heap, n, 0, opts);
+        }
+    }
+    dir_reader_close(&dir);
+
+    // drain worst-first into display order
+    topk_entry_t* sorted = xmalloc((size_t)(n ? n : 1) * sizeof(topk_entry_t));
+    for(int k = n; k > 0; --k){
+        int pos = opts->limit_tail ? n - k : k - 1;
+        sorted[pos] = heap[0];
+        heap[0] = heap[k - 1];
+        sift_down(heap, k - 1, 0, opts);
+    }
+    // --tail drains first-displayed first, --head last-displayed first
+    for(int i = 0; i < n; ++i){
+        const char* name = sorted[i].info.name;
+        file_info_t* info = file_list_add(&flist, name, strlen(name));
+        sorted[i].info.name = info->name;
+        sorted[i].info.width = info->width;
+        *info = sorted[i].info;
+        free((char*)name);
+    }
+    free(sorted);
+    free(heap);
+    return flist;
+}
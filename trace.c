@@ -0,0 +1,252 @@
+/*
+ * Timeline Tracing (--trace=FILE)
+ * -------------------------------
+ * Records what every thread was doing as complete ("X") events of the
+ * Chrome Trace Event format, which chrome://tracing and Perfetto load
+ * directly.
+ *
+ * Spans come from two places: the --stats phase spans (classification,
+ * each directory read, each sort, each print), which stats_end() hands to
+ * trace_span() when tracing is on, and trace-only spans around stat
+ * batches and output flushes.
+ *
+ * Each thread appends to its own buffer of event chunks and a string
+ * arena for the event details, so recording takes no lock and shares no
+ * cache line with other threads; a buffer is published once, with a
+ * compare-and-swap push onto the list of buffers. The file is written by
+ * trace_finish() after all workers have been joined.
+ */
+
+#include "myls.h"
+#include<stdatomic.h>
+#include<sys/syscall.h>
+
+#define TRACE_CHUNK_EVENTS 4096
+#define TRACE_TEXT_CHUNK   (64 * 1024)
+
+/*
+ * trace_event_t
+ * -------------
+ * One complete event.
+ *
+ * Fields:
+ *   name   - static span name
+ *   detail - directory or other object of the span (thread arena), or NULL
+ *   items  - entries, operands or bytes handled by the span
+ *   start  - stats_clock() time the span began
+ *   end    - stats_clock() time the span ended
+ */
+typedef struct{
+    const char* name;
+    const char* detail;
+    uint64_t items;
+    uint64_t start;
+    uint64_t end;
+}trace_event_t;
+
+typedef struct trace_chunk{
+    struct trace_chunk* next;
+    int count;
+    trace_event_t events[TRACE_CHUNK_EVENTS];
+}trace_chunk_t;
+
+typedef struct trace_text{
+    struct trace_text* next;
+    size_t used;
+    size_t cap;
+    char data[];
+}trace_text_t;
+
+/*
+ * trace_buffer_t
+ * --------------
+ * Events of one thread, newest chunk first.
+ *
+ * Fields:
+ *   tid    - kernel thread id, used as the trace "tid"
+ *   events - event chunks, the head being filled
+ *   text   - arena holding copies of the event details
+ *   next   - next published buffer
+ */
+typedef struct trace_buffer{
+    long tid;
+    trace_chunk_t* events;
+    trace_text_t* text;
+    struct trace_buffer* next;
+}trace_buffer_t;
+
+bool trace_enabled = false;
+
+static struct{
+    FILE* file;
+    uint64_t origin;                  // stats_clock() at trace_start()
+    _Atomic(trace_buffer_t*) buffers;
+}trace;
+
+static __thread trace_buffer_t* tls_trace = NULL;
+
+static trace_buffer_t* trace_buffer(void){
+    trace_buffer_t* buf = xmalloc(sizeof(*buf));
+    buf->tid = (long)syscall(SYS_gettid);
+    buf->events = NULL;
+    buf->text = NULL;
+    buf->next = atomic_load_explicit(&trace.buffers, memory_order_relaxed);
+    while(!atomic_compare_exchange_weak_explicit(&trace.buffers, &buf->next, buf,
+                                                 memory_order_release, memory_order_relaxed))
+        ;
+    tls_trace = buf;
+    return buf;
+}
+
+// copy a detail string into the thread's arena
+static const char* trace_text(trace_buffer_t* buf, const char* s){
+    size_t len = strlen(s) + 1;
+    trace_text_t* t = buf->text;
+    if(!t || t->cap - t->used < len){
+        size_t cap = len > TRACE_TEXT_CHUNK ? len : TRACE_TEXT_CHUNK;
+        t = xmalloc(sizeof(trace_text_t) + cap);
+        t->next = buf->text;
+        t->used = 0;
+        t->cap = cap;
+        buf->text = t;
+    }
+    char* copy = t->data + t->used;
+    memcpy(copy, s, len);
+    t->used += len;
+    return copy;
+}
+
+/*
+ * trace_start
+ * -----------
+ * Open the trace file and enable recording.
+ *
+ * Returns:
+ *   0 on success, -1 if the file cannot be created (errno is set).
+ */
+int trace_start(const char* path){
+    trace.file = fopen(path, "w");
+    if(!trace.file)
+        return -1;
+    trace.origin = stats_clock();
+    trace_enabled = true;
+    return 0;
+}
+
+/*
+ * trace_span
+ * ----------
+ * Record a span of the calling thread that ran from start until now.
+ *
+ * Parameters:
+ *   name   - span name (must be a string literal or otherwise static)
+ *   detail - directory or other object of the span, copied; may be NULL
+ *   items  - entries, operands or bytes handled by the span
+ *   start  - stats_clock() time the span began
+ */
+void trace_span(const char* name, const char* detail, uint64_t items, uint64_t start){
+    uint64_t end = stats_clock();
+    trace_buffer_t* buf = tls_trace ? tls_trace : trace_buffer();
+    trace_chunk_t* chunk = buf->events;
+    if(!chunk || chunk->count == TRACE_CHUNK_EVENTS){
+        chunk = xmalloc(sizeof(*chunk));
+        chunk->next = buf->events;
+        chunk->count = 0;
+        buf->events = chunk;
+    }
+    trace_event_t* ev = &chunk->events[chunk->count++];
+    ev->name = name;
+    ev->detail = detail ? trace_text(buf, detail) : NULL;
+    ev->items = items;
+    ev->start = start;
+    ev->end = end;
+}
+
+/*
+ * write_events
+ * ------------
+ * Write the events of one thread in recording order. The chunk list is
+ * reversed in place (oldest first) on the way.
+ */
+static void write_events(FILE* f, trace_buffer_t* buf, long pid, uint64_t origin, bool* first){
+    trace_chunk_t* oldest = NULL;
+    while(buf->events){
+        trace_chunk_t* next = buf->events->next;
+        buf->events->next = oldest;
+        oldest = buf->events;
+        buf->events = next;
+    }
+    buf->events = oldest;
+
+    for(const trace_chunk_t* chunk = oldest; chunk; chunk = chunk->next){
+        for(int i = 0; i < chunk->count; ++i){
+            const trace_event_t* ev = &chunk->events[i];
+            uint64_t start = ev->start - origin;
+            fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"myls\",\"ph\":\"X\",\"pid\":%ld,\"tid\":%ld,"
+                       "\"ts\":%llu.%03u,\"dur\":%llu.%03u,\"args\":{\"items\":%llu",
+                    *first ? "" : ",", ev->name, pid, buf->tid,
+                    (unsigned long long)(start / 1000), (unsigned)(start % 1000),
+                    (unsigned long long)((ev->end - ev->start) / 1000),
+                    (unsigned)((ev->end - ev->start) % 1000),
+                    (unsigned long long)ev->items);
+            if(ev->detail){
+                fprintf(f, ",\"path\":");
+                json_string(f, ev->detail);
+            }
+            fprintf(f, "}}");
+            *first = false;
+        }
+    }
+}
+
+/*
+ * trace_finish
+ * ------------
+ * Write all buffers to the trace file, close it and release the buffers.
+ * Must run after every worker thread has been joined.
+ *
+ * Behavior:
+ *   - Emits {"traceEvents": [...]} with timestamps in microseconds since
+ *     trace_start(), one "X" event per span and a thread_name metadata
+ *     event per thread ("main" for the process's initial thread)
+ *   - Reports a write error on stderr
+ */
+void trace_finish(void){
+    if(!trace_enabled)
+        return;
+    FILE* f = trace.file;
+    long pid = (long)getpid();
+    bool first = true;
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    trace_buffer_t* buf = atomic_load_explicit(&trace.buffers, memory_order_acquire);
+    for(; buf; buf = buf->next){
+        fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%ld,"
+                   "\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",", pid, buf->tid, buf->tid == pid ? "main" : "worker");
+        first = false;
+        write_events(f, buf, pid, trace.origin, &first);
+    }
+    fprintf(f, "\n]}\n");
+    int failed = ferror(f);
+    if(fclose(f) || failed)
+        fprintf(stderr, "myls: error writing trace file\n");
+
+    buf = atomic_exchange(&trace.buffers, NULL);
+    while(buf){
+        trace_buffer_t* next = buf->next;
+        while(buf->events){
+            trace_chunk_t* chunk = buf->events->next;
+            free(buf->events);
+            buf->events = chunk;
+        }
+        while(buf->text){
+            trace_text_t* t = buf->text->next;
+            free(buf->text);
+            buf->text = t;
+        }
+        free(buf);
+        buf = next;
+    }
+    trace_enabled = false;
+    tls_trace = NULL;
+}
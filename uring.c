@@ -0,0 +1,353 @@
+/*
+ * io_uring Stat Engine
+ * --------------------
+ * Batched statx submission used by read_directory() with --io-uring.
+ *
+ * A single ring is created per run. For each directory, IORING_OP_STATX
+ * requests are queued for the collected entries, up to the ring depth at a
+ * time, and completions are reaped in bulk; one io_uring_enter() call both
+ * submits the new requests and waits for finished ones. This keeps a deep
+ * queue of metadata lookups in flight from a single thread, without the
+ * context switches of a thread pool.
+ *
+ * The ring is driven through the raw system calls, so no liburing is
+ * needed. When io_uring or IORING_OP_STATX is unavailable (old kernel,
+ * seccomp, non-Linux systems), uring_start() fails and read_directory()
+ * falls back to the synchronous stat loop.
+ */
+
+#include "myls.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>) && defined(STATX_TYPE)
+#define HAVE_IO_URING 1
+#include<linux/io_uring.h>
+#include<sys/mman.h>
+#include<sys/syscall.h>
+#include<unistd.h>
+#include<pthread.h>
+#endif
+
+#ifdef HAVE_IO_URING
+
+#define URING_DEPTH 256
+
+static struct{
+    int fd;
+    bool broken;                // io_uring_enter failed; stop using the ring
+    arena_chunk_t* orphans;     // names of requests lost in flight, never freed
+    pthread_mutex_t lock;       // one directory batch at a time
+
+    // submission queue
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    struct io_uring_sqe* sqes;
+    unsigned sq_entries;
+
+    // completion queue
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+
+    // mappings, kept for munmap
+    void* sq_ptr;
+    void* cq_ptr;
+    size_t sq_size;
+    size_t cq_size;
+    size_t sqes_size;
+
+    // per-request slots: statx buffer, the entry it belongs to and the
+    // time it was queued (--stats)
+    struct statx* bufs;
+    int* slot_entry;
+    uint64_t* slot_start;
+    int* free_slots;
+}ring = {
+    .fd = -1,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/*
+ * uring_supports_statx
+ * --------------------
+ * Ask the kernel whether IORING_OP_STATX is implemented (Linux 5.6+).
+ */
+static bool uring_supports_statx(int fd){
+    size_t len = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe* probe = xmalloc(len);
+    memset(probe, 0, len);
+
+    bool ok = false;
+    if(syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) == 0)
+        ok = probe->last_op >= IORING_OP_STATX &&
+             (probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED);
+    free(probe);
+    return ok;
+}
+
+/*
+ * uring_start
+ * -----------
+ * Create the ring and map its queues.
+ *
+ * Returns:
+ *   0 on success, -1 if io_uring (or its statx operation) is unavailable,
+ *   in which case callers must use the synchronous path.
+ */
+int uring_start(void){
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = (int)syscall(__NR_io_uring_setup, URING_DEPTH, &params);
+    if(fd < 0)
+        return -1;
+    if(!uring_supports_statx(fd)){
+        close(fd);
+        return -1;
+    }
+
+    ring.sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring.cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+    if(single){
+        if(ring.cq_size > ring.sq_size)
+            ring.sq_size = ring.cq_size;
+        ring.cq_size = ring.sq_size;
+    }
+
+    ring.sq_ptr = mmap(NULL, ring.sq_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if(ring.sq_ptr == MAP_FAILED){
+        close(fd);
+        return -1;
+    }
+    ring.cq_ptr = single ? ring.sq_ptr
+                         : mmap(NULL, ring.cq_size, PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    ring.sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring.sqes = mmap(NULL, ring.sqes_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if(ring.cq_ptr == MAP_FAILED || ring.sqes == MAP_FAILED){
+        if(ring.sqes != MAP_FAILED)
+            munmap(ring.sqes, ring.sqes_size);
+        if(!single && ring.cq_ptr != MAP_FAILED)
+            munmap(ring.cq_ptr, ring.cq_size);
+        munmap(ring.sq_ptr, ring.sq_size);
+        close(fd);
+        return -1;
+    }
+
+    char* sq = ring.sq_ptr;
+    ring.sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring.sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring.sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring.sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring.sq_entries = params.sq_entries;
+
+    char* cq = ring.cq_ptr;
+    ring.cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring.cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring.cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    ring.bufs = xmalloc(ring.sq_entries * sizeof(struct statx));
+    ring.slot_entry = xmalloc(ring.sq_entries * sizeof(int));
+    ring.slot_start = xmalloc(ring.sq_entries * sizeof(uint64_t));
+    ring.free_slots = xmalloc(ring.sq_entries * sizeof(int));
+    ring.fd = fd;
+    return 0;
+}
+
+/*
+ * uring_stop
+ * ----------
+ * Unmap and close the ring. Safe to call when the ring was never started.
+ *
+ * Notes:
+ *   - The statx buffers of a broken ring are not freed: requests it lost
+ *     in flight may still be completed by the kernel after the close
+ */
+void uring_stop(void){
+    if(ring.fd < 0)
+        return;
+    munmap(ring.sqes, ring.sqes_size);
+    if(ring.cq_ptr != ring.sq_ptr)
+        munmap(ring.cq_ptr, ring.cq_size);
+    munmap(ring.sq_ptr, ring.sq_size);
+    close(ring.fd);
+    if(!ring.broken)
+        free(ring.bufs);
+    free(ring.slot_entry);
+    free(ring.slot_start);
+    free(ring.free_slots);
+    ring.fd = -1;
+}
+
+/*
+ * uring_drain
+ * -----------
+ * After io_uring_enter() failed mid-batch, wait for the requests the
+ * kernel already took from the submission queue and discard their
+ * completions. Requests still in the queue are never submitted, since a
+ * broken ring is not entered again.
+ *
+ * Parameters:
+ *   inflight - requests queued and not yet reaped
+ *
+ * Returns:
+ *   true once none is left in flight, false if waiting fails as well.
+ */
+static bool uring_drain(int inflight){
+    inflight -= (int)(*ring.sq_tail - __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE));
+    for(;;){
+        unsigned head = *ring.cq_head;
+        unsigned ctail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        inflight -= (int)(ctail - head);
+        __atomic_store_n(ring.cq_head, ctail, __ATOMIC_RELEASE);
+        if(inflight <= 0)
+            return true;
+        long ret = syscall(__NR_io_uring_enter, ring.fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        if(ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            return false;
+    }
+}
+
+/*
+ * uring_stat_run
+ * --------------
+ * Stat every entry of a list through the ring and drop the ones that fail.
+ *
+ * Parameters:
+ *   dfd    - file descriptor of the directory holding the entries
+ *   flist  - entries collected by read_directory(), names already set
+ *   fields - STAT_NEED_* mask, translated to the statx mask
+ *
+ * Returns:
+ *   0 when the batch was handled, -1 if the ring is not available or
+ *   failed mid-batch; the caller must then stat the whole list another way.
+ *
+ * Behavior:
+ *   - Keeps up to the ring depth of IORING_OP_STATX requests in flight,
+ *     refilling freed slots with the next entries after every reap
+ *   - Uses AT_SYMLINK_NOFOLLOW relative to dfd, like stat_entry()
+ *   - Compacts out failed entries in their original order, so results
+ *     match the synchronous loop exactly
+ *   - If io_uring_enter() fails, marks the ring broken and drains the
+ *     requests in flight before returning; if that fails too, the list's
+ *     names are copied and the old copies handed to the ring, so nothing
+ *     the kernel may still touch is freed or reused
+ */
+int uring_stat_run(int dfd, file_list_t* flist, unsigned fields){
+    if(ring.fd < 0 || ring.broken)
+        return -1;
+    if(flist->count == 0)
+        return 0;
+
+    unsigned mask = statx_mask(fields);
+
+    bool* failed = xmalloc((size_t)flist->count * sizeof(bool));
+
+    uint64_t batch_start = trace_begin();
+    pthread_mutex_lock(&ring.lock);
+    int nfree = 0;
+    for(unsigned s = 0; s < ring.sq_entries; ++s)
+        ring.free_slots[nfree++] = (int)s;
+
+    int next = 0;
+    int inflight = 0;
+    while(next < flist->count || inflight > 0){
+        // queue requests into free slots
+        unsigned tail = *ring.sq_tail;
+        while(next < flist->count && nfree > 0){
+            int slot = ring.free_slots[--nfree];
+            ring.slot_entry[slot] = next;
+            ring.slot_start[slot] = stats_call_begin();
+
+            unsigned idx = tail & *ring.sq_mask;
+            struct io_uring_sqe* sqe = &ring.sqes[idx];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = dfd;
+            sqe->addr = (unsigned long)flist->files[next].name;
+            sqe->len = mask;
+            sqe->off = (unsigned long)&ring.bufs[slot];
+            sqe->statx_flags = AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT;
+            sqe->user_data = (uint64_t)slot;
+            ring.sq_array[idx] = idx;
+            tail++;
+            next++;
+            inflight++;
+        }
+        __atomic_store_n(ring.sq_tail, tail, __ATOMIC_RELEASE);
+
+        // submit whatever the kernel has not consumed yet, wait for one
+        unsigned pending = tail - __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE);
+        uint64_t start = stats_call_begin();
+        long ret = syscall(__NR_io_uring_enter, ring.fd, pending, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        stats_call_end(STATS_SYS_URING_ENTER, start, NULL);
+        if(ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY){
+            ring.broken = true;
+            if(!uring_drain(inflight)){
+                arena_chunk_t* old = file_list_detach_names(flist);
+                arena_chunk_t* last = old;
+                while(last && last->next)
+                    last = last->next;
+                if(last){
+                    last->next = ring.orphans;
+                    ring.orphans = old;
+                }
+            }
+            break;
+        }
+
+        // reap completions in bulk
+        unsigned head = *ring.cq_head;
+        unsigned ctail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        for(; head != ctail; ++head){
+            struct io_uring_cqe* cqe = &ring.cqes[head & *ring.cq_mask];
+            int slot = (int)cqe->user_data;
+            int i = ring.slot_entry[slot];
+            if(cqe->res == 0){
+                statx_fill(&flist->files[i], &ring.bufs[slot]);
+                failed[i] = false;
+            }
+            else
+                failed[i] = true;
+            ring.free_slots[nfree++] = slot;
+            inflight--;
+            stats_call_end(STATS_SYS_URING_STATX, ring.slot_start[slot], flist->files[i].name);
+        }
+        __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    pthread_mutex_unlock(&ring.lock);
+    trace_end("uring stat batch", stats_dir(), (uint64_t)flist->count, batch_start);
+    if(ring.broken){
+        free(failed);
+        return -1;
+    }
+
+    file_list_drop_failed(flist, failed);
+    free(failed);
+    return 0;
+}
+
+#else
+
+int uring_start(void){
+    return -1;
+}
+
+void uring_stop(void){
+}
+
+int uring_stat_run(int dfd, file_list_t* flist, unsigned fields){
+    (void)dfd;
+    (void)flist;
+    (void)fields;
+    return -1;
+}
+
+#endif